@@ -21,7 +21,7 @@ W25Q64_status_t W25Q64::init(int cs_pin){
 
     // read the device ID 
     byte manufacturer_id, device_id; 
-    _status = readManufacturerId(&manufacturer_id, &device_id); 
+    readManufacturerId(&manufacturer_id, &device_id); 
     // check the expected IDs 
     if(manufacturer_id != 0xEF){
         return W25Q64_UNKOWN_MANUFACTURER_ID; 
@@ -44,6 +44,7 @@ bool W25Q64::busy(){
 
 W25Q64_status_t W25Q64::reset(){
     // check status 
+    W25Q64_Guard guard(_lock); 
     if(busy()) return W25Q64_BUSY; 
     // enable a reset 
     enableReset(); 
@@ -52,6 +53,88 @@ W25Q64_status_t W25Q64::reset(){
     return W25Q64_OK; 
 }
 
+W25Q64_status_t W25Q64::waitWhileBusy(){
+    // poll the busy bit, let other tasks run in the meantime 
+    while(busy()){
+        yield(); 
+    }
+    return W25Q64_OK; 
+}
+
+W25Q64_status_t W25Q64::program(unsigned int addr, byte* buff, unsigned int len){
+    // write enable and program go out back to back, no other task can slip a command in between 
+    _lockIdle(); 
+    writeEnable(); 
+    W25Q64_status_t status = pageProgram(addr, buff, len); 
+    unlock(); 
+    if(status != W25Q64_OK) return status; 
+    return waitWhileBusy(); 
+}
+
+W25Q64_status_t W25Q64::erase(unsigned int addr){
+    _lockIdle(); 
+    writeEnable(); 
+    W25Q64_status_t status = sectorErase(addr); 
+    unlock(); 
+    if(status != W25Q64_OK) return status; 
+    return waitWhileBusy(); 
+}
+
+W25Q64_Observer::~W25Q64_Observer(){
+    detach(); 
+}
+
+void W25Q64_Observer::detach(){
+    if(_observed != NULL) _observed->removeObserver(this); 
+}
+
+void W25Q64::addObserver(W25Q64_Observer* observer){
+    // an observer has one link, it can only be in one chip's list 
+    observer->detach(); 
+    W25Q64_Guard guard(_lock); 
+    observer->_next_observer = _observers; 
+    observer->_observed = this; 
+    _observers = observer; 
+}
+
+void W25Q64::removeObserver(W25Q64_Observer* observer){
+    W25Q64_Guard guard(_lock); 
+    W25Q64_Observer** link = &_observers; 
+    while(*link != NULL){
+        if(*link == observer){
+            *link = observer->_next_observer; 
+            observer->_next_observer = NULL; 
+            observer->_observed = NULL; 
+            return; 
+        }
+        link = &(*link)->_next_observer; 
+    }
+}
+
+W25Q64_status_t W25Q64::_writable(bool* enabled){
+    // one status read gives both the busy bit and the write enable latch 
+    byte status_reg_1; 
+    readStatusRegister1(&status_reg_1); 
+    *enabled = (status_reg_1&0b00000010) != 0; 
+    if(status_reg_1&0b00000001) return W25Q64_BUSY; 
+    return W25Q64_OK; 
+}
+
+void W25Q64::_notify(W25Q64_mutation_t kind, unsigned int addr, const byte* data, unsigned int len){
+    for(W25Q64_Observer* observer = _observers; observer != NULL; observer = observer->_next_observer){
+        observer->mutated(kind, addr, data, len); 
+    }
+}
+
+void W25Q64::_lockIdle(){
+    while(true){
+        lock(); 
+        if(!busy()) return; 
+        unlock(); 
+        yield(); 
+    }
+}
+
 // chip instructions \\ 
 
 W25Q64_status_t W25Q64::writeEnable(){
@@ -118,11 +201,13 @@ W25Q64_status_t W25Q64::readUniqueId(byte *unique_id){
         *unique_id = SPI.transfer(0); 
         *unique_id ++; 
     }
+    _release(); 
     return W25Q64_OK; 
 }
 
 W25Q64_status_t W25Q64::readData(unsigned int addr, byte* buff, unsigned int len){
     // check if busy 
+    W25Q64_Guard guard(_lock); 
     if(busy()) return W25Q64_BUSY; 
     // transaction 
     _select(); 
@@ -146,6 +231,7 @@ W25Q64_status_t W25Q64::readData(unsigned int addr, byte* buff, unsigned int len
 
 W25Q64_status_t W25Q64::fastRead(unsigned int addr, byte* buff, unsigned int len){
     // check if busy 
+    W25Q64_Guard guard(_lock); 
     if(busy()) return W25Q64_BUSY; 
     // transaction 
     _select(); 
@@ -169,7 +255,11 @@ W25Q64_status_t W25Q64::fastRead(unsigned int addr, byte* buff, unsigned int len
 
 W25Q64_status_t W25Q64::pageProgram(unsigned int addr, byte* buff, unsigned int len){
     // check if busy 
-    if(busy()) return W25Q64_BUSY; 
+    W25Q64_Guard guard(_lock); 
+    bool enabled; 
+    if(_writable(&enabled) != W25Q64_OK) return W25Q64_BUSY; 
+    byte* data = buff; 
+    unsigned int data_len = len; 
     // assume that a write enable command has already been issued 
     // assume no security lockouts 
     _select(); 
@@ -185,12 +275,15 @@ W25Q64_status_t W25Q64::pageProgram(unsigned int addr, byte* buff, unsigned int
         len --; 
     }
     _release(); 
+    if(enabled) _notify(W25Q64_MUTATION_PROGRAM, addr, data, data_len); 
     return W25Q64_OK;
 }
 
 W25Q64_status_t W25Q64::sectorErase(unsigned int addr){
     // check if busy 
-    if(busy()) return W25Q64_BUSY; 
+    W25Q64_Guard guard(_lock); 
+    bool enabled; 
+    if(_writable(&enabled) != W25Q64_OK) return W25Q64_BUSY; 
     // assume that a write enable command has already been issued 
     // assume no security lockouts 
     _select(); 
@@ -200,12 +293,15 @@ W25Q64_status_t W25Q64::sectorErase(unsigned int addr){
         SPI.transfer((byte)(addr >> ((2-i)*8))); 
     }
     _release(); 
+    if(enabled) _notify(W25Q64_MUTATION_ERASE, addr - addr % W25Q64_SECTOR_SIZE, NULL, W25Q64_SECTOR_SIZE); 
     return W25Q64_OK;
 }
 
 W25Q64_status_t W25Q64::block32Erase(unsigned int addr){
     // check if busy 
-    if(busy()) return W25Q64_BUSY; 
+    W25Q64_Guard guard(_lock); 
+    bool enabled; 
+    if(_writable(&enabled) != W25Q64_OK) return W25Q64_BUSY; 
     // assume that a write enable command has already been issued 
     // assume no security lockouts 
     _select(); 
@@ -215,12 +311,15 @@ W25Q64_status_t W25Q64::block32Erase(unsigned int addr){
         SPI.transfer((byte)(addr >> ((2-i)*8))); 
     }
     _release(); 
+    if(enabled) _notify(W25Q64_MUTATION_ERASE, addr - addr % W25Q64_BLOCK_32_SIZE, NULL, W25Q64_BLOCK_32_SIZE); 
     return W25Q64_OK;
 }
 
 W25Q64_status_t W25Q64::block64Erase(unsigned int addr){
     // check if busy 
-    if(busy()) return W25Q64_BUSY; 
+    W25Q64_Guard guard(_lock); 
+    bool enabled; 
+    if(_writable(&enabled) != W25Q64_OK) return W25Q64_BUSY; 
     // assume that a write enable command has already been issued 
     // assume no security lockouts 
     _select(); 
@@ -230,17 +329,21 @@ W25Q64_status_t W25Q64::block64Erase(unsigned int addr){
         SPI.transfer((byte)(addr >> ((2-i)*8))); 
     }
     _release(); 
+    if(enabled) _notify(W25Q64_MUTATION_ERASE, addr - addr % W25Q64_BLOCK_64_SIZE, NULL, W25Q64_BLOCK_64_SIZE); 
     return W25Q64_OK;
 }
 
 W25Q64_status_t W25Q64::chipErase(){
     // check if busy 
-    if(busy()) return W25Q64_BUSY; 
+    W25Q64_Guard guard(_lock); 
+    bool enabled; 
+    if(_writable(&enabled) != W25Q64_OK) return W25Q64_BUSY; 
     // assume that a write enable command has already been issued 
     // assume no security lockouts 
     _select(); 
     SPI.transfer(W25Q64_CHIP_ERASE); 
     _release(); 
+    if(enabled) _notify(W25Q64_MUTATION_ERASE, 0, NULL, W25Q64_MAX_ADDRESS + 1); 
     return W25Q64_OK;
 }
 
@@ -254,6 +357,7 @@ W25Q64_status_t W25Q64::readStatusRegister1(byte* reg){
 
 W25Q64_status_t W25Q64::writeStatusRegister1(byte reg){
     // check if busy 
+    W25Q64_Guard guard(_lock); 
     if(busy()) return W25Q64_BUSY; 
     // assume that a write enable command has already been issued 
     _select(); 
@@ -273,6 +377,7 @@ W25Q64_status_t W25Q64::readStatusRegister2(byte* reg){
 
 W25Q64_status_t W25Q64::writeStatusRegister2(byte reg){
     // check if busy 
+    W25Q64_Guard guard(_lock); 
     if(busy()) return W25Q64_BUSY; 
     // assume that a write enable command has already been issued 
     _select(); 
@@ -292,6 +397,7 @@ W25Q64_status_t W25Q64::readStatusRegister3(byte* reg){
 
 W25Q64_status_t W25Q64::writeStatusRegister3(byte reg){
     // check if busy 
+    W25Q64_Guard guard(_lock); 
     if(busy()) return W25Q64_BUSY; 
     // assume that a write enable command has already been issued 
     _select(); 
@@ -303,6 +409,7 @@ W25Q64_status_t W25Q64::writeStatusRegister3(byte reg){
 
 W25Q64_status_t W25Q64::readSFDPRegister(unsigned int addr, byte* buff, unsigned int len){
     // check if busy 
+    W25Q64_Guard guard(_lock); 
     if(busy()) return W25Q64_BUSY; 
     // transaction 
     _select(); 
@@ -326,6 +433,7 @@ W25Q64_status_t W25Q64::readSFDPRegister(unsigned int addr, byte* buff, unsigned
 
 W25Q64_status_t W25Q64::eraseSecurityRegister(unsigned int addr){
     // check if busy 
+    W25Q64_Guard guard(_lock); 
     if(busy()) return W25Q64_BUSY; 
     // assume that a write enable command has already been issued 
     _select(); 
@@ -340,6 +448,7 @@ W25Q64_status_t W25Q64::eraseSecurityRegister(unsigned int addr){
 
 W25Q64_status_t W25Q64::programSecurityRegister(unsigned int addr, byte* buff, unsigned int len){
     // check if busy 
+    W25Q64_Guard guard(_lock); 
     if(busy()) return W25Q64_BUSY; 
     // assume that a write enable command has already been issued
     // transaction 
@@ -362,6 +471,7 @@ W25Q64_status_t W25Q64::programSecurityRegister(unsigned int addr, byte* buff, u
 
 W25Q64_status_t W25Q64::readSecurityRegister(unsigned int addr, byte* buff, unsigned int len){
     // check if busy 
+    W25Q64_Guard guard(_lock); 
     if(busy()) return W25Q64_BUSY; 
     // transaction 
     _select(); 
@@ -58,6 +58,11 @@
 
 // Chip Settings 
 #define W25Q64_MAX_ADDRESS                  0x7FFFFFL // Max address, 8M-bit 
+#define W25Q64_PAGE_SIZE                    256 // bytes per program page 
+#define W25Q64_SECTOR_SIZE                  4096 // bytes per erasable sector 
+#define W25Q64_BLOCK_32_SIZE                32768 
+#define W25Q64_BLOCK_64_SIZE                65536 
+#define W25Q64_SECTOR_COUNT                 2048 
 
 // extraneous chip commands/settings/registers 
 
@@ -66,10 +71,100 @@ typedef enum{
     W25Q64_OK = 0, 
     W25Q64_BUSY, 
     W25Q64_UNKOWN_MANUFACTURER_ID,
-    W25Q64_UNKOWN_DEVICE_ID
+    W25Q64_UNKOWN_DEVICE_ID,
+    W25Q64_INVALID_ADDRESS, 
+    W25Q64_FULL, 
+    W25Q64_INVALID_ARGUMENT, 
+    W25Q64_NOT_FOUND, 
+    W25Q64_CORRUPT
 
 } W25Q64_status_t; 
 
+/**
+ * @brief lock shared by everything that talks to a chip 
+ * 
+ * Implement with the mutex of the platform, e.g. a FreeRTOS recursive mutex or std::recursive_mutex. The lock must be 
+ *  recursive, a task already holding it takes it again for every command inside a locked sequence 
+ * 
+ */
+class W25Q64_Lock{
+public: 
+    /**
+     * @brief take the lock, blocking until it is free 
+     * 
+     */
+    virtual void lock() = 0; 
+
+    /**
+     * @brief give the lock back 
+     * 
+     */
+    virtual void unlock() = 0; 
+}; 
+
+/**
+ * @brief holds a lock for the lifetime of the guard, no-op without a lock 
+ * 
+ */
+class W25Q64_Guard{
+public: 
+    W25Q64_Guard(W25Q64_Lock* lock) : _lock(lock){
+        if(_lock != NULL) _lock->lock(); 
+    };
+    ~W25Q64_Guard(){
+        if(_lock != NULL) _lock->unlock(); 
+    };
+
+private: 
+    W25Q64_Lock* _lock; ///< lock held, NULL for none 
+}; 
+
+/**
+ * @brief kinds of change made to the memory array 
+ * 
+ */
+typedef enum{
+    W25Q64_MUTATION_PROGRAM = 0,    ///< bytes programmed, only bits cleared 
+    W25Q64_MUTATION_ERASE           ///< range erased to 0xFF 
+} W25Q64_mutation_t; 
+
+class W25Q64; 
+
+/**
+ * @brief told about every program and erase sent to a chip 
+ * 
+ * Lets caches, indexes and filters built over the chip follow changes made through any path, including direct driver 
+ *  calls. mutated() runs right after the command is sent, before the chip has finished it, with the driver lock held; 
+ *  keep it short and do not send commands to the chip from it. An observer is on at most one chip, adding it to another 
+ *  moves it, and it is removed when it is destroyed 
+ * 
+ */
+class W25Q64_Observer{
+public: 
+    virtual ~W25Q64_Observer(); 
+
+    /**
+     * @brief called for each program or erase 
+     * 
+     * @param kind what happened to the range 
+     * @param addr start of the range 
+     * @param data bytes programmed, NULL for an erase 
+     * @param len length of the range 
+     */
+    virtual void mutated(W25Q64_mutation_t kind, unsigned int addr, const byte* data, unsigned int len) = 0; 
+
+    /**
+     * @brief stop observing the chip the observer was added to, if any 
+     * 
+     */
+    void detach(); 
+
+private: 
+    friend class W25Q64; 
+    W25Q64* _observed = NULL; ///< chip the observer is registered on 
+    W25Q64_Observer* _next_observer = NULL; ///< next observer of the same chip 
+}; 
+
 /**
  * @brief Handler class for the W25Q64 family of FLASH chips 
  * 
@@ -106,6 +201,74 @@ public:
      * @return W25Q64_status_t standard return type 
      */
     W25Q64_status_t reset();  
+
+    /**
+     * @brief wait for the chip to finish an operation 
+     * 
+     * Polls the busy bit until the current program/erase completes 
+     * 
+     * @return W25Q64_status_t standard return type 
+     */
+    W25Q64_status_t waitWhileBusy(); 
+
+    /**
+     * @brief make the driver safe to share between tasks 
+     * 
+     * Every command is sent with the lock held, commands that check busy first hold it from the check to the end of the 
+     *  command. waitWhileBusy() only holds it for each status poll so other tasks can use the bus during tPP/tSE 
+     * 
+     * @param lock recursive lock, NULL to run without locking 
+     */
+    void setLock(W25Q64_Lock* lock){_lock = lock;}; 
+
+    /**
+     * @brief take the driver lock to group several commands into one sequence 
+     * 
+     */
+    void lock(){if(_lock != NULL) _lock->lock();}; 
+
+    /**
+     * @brief give the driver lock back 
+     * 
+     */
+    void unlock(){if(_lock != NULL) _lock->unlock();}; 
+
+    /**
+     * @brief program up to a page as one locked sequence and wait for it 
+     * 
+     * Waits for the chip to be idle, sends WRITE ENABLE and PAGE PROGRAM without letting another task in between, then 
+     *  waits for the program with the lock released 
+     * 
+     * @param addr address to program 
+     * @param buff buffer of data to program 
+     * @param len length of the data, at most to the end of the page 
+     * @return W25Q64_status_t standard return type 
+     */
+    W25Q64_status_t program(unsigned int addr, byte* buff, unsigned int len); 
+
+    /**
+     * @brief erase a sector as one locked sequence and wait for it 
+     * 
+     * @param addr address in the sector to erase 
+     * @return W25Q64_status_t standard return type 
+     */
+    W25Q64_status_t erase(unsigned int addr); 
+
+    /**
+     * @brief register an observer for programs and erases 
+     * 
+     * Only commands the chip accepts are reported, WRITE ENABLE has to be set when they are sent 
+     * 
+     * @param observer observer to add, removed from the chip it was on before 
+     */
+    void addObserver(W25Q64_Observer* observer); 
+
+    /**
+     * @brief stop reporting to an observer 
+     * 
+     * @param observer observer to remove 
+     */
+    void removeObserver(W25Q64_Observer* observer); 
         
     // chip instructions \\ 
 
@@ -372,7 +535,30 @@ public:
 private: 
     SPISettings _spi_settings = SPISettings(W25Q64_SPI_SPEED, W25Q64_SPI_DATA_ORDER, W25Q64_SPI_MODE); ///< spi settings for the flash chip  
     int _cs_pin; ///< chip select pin for the flash chip 
-    W25Q64_status_t _status;  ///< general status for chip functions 
+    W25Q64_Lock* _lock = NULL; ///< lock taken for every command, NULL for none 
+    W25Q64_Observer* _observers = NULL; ///< first observer told about changes 
+
+    /**
+     * @brief check that a program or erase can be sent 
+     * 
+     * @param enabled set to the WRITE ENABLE latch, the chip ignores the command without it 
+     * @return W25Q64_status_t W25Q64_BUSY if the chip is busy 
+     */
+    W25Q64_status_t _writable(bool* enabled); 
+
+    /**
+     * @brief tell every observer about a change 
+     * 
+     */
+    void _notify(W25Q64_mutation_t kind, unsigned int addr, const byte* data, unsigned int len); 
+
+    /**
+     * @brief take the lock once the chip is idle 
+     * 
+     * Polls busy, giving the lock back between polls, returns holding the lock with the chip idle 
+     * 
+     */
+    void _lockIdle(); 
 
 
 
@@ -384,6 +570,8 @@ private:
      * 
      */
     void _select(){
+        // every transaction is made with the lock held 
+        lock(); 
         // select the cs_pin 
         digitalWrite(_cs_pin, LOW); 
         // begin transaction with settings 
@@ -401,6 +589,7 @@ private:
         digitalWrite(_cs_pin, HIGH); 
         // release transaction 
         SPI.endTransaction(); 
+        unlock(); 
     };  
 
 
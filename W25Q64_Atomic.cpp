@@ -0,0 +1,195 @@
+/**
+ * @file W25Q64_Atomic.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 atomic multi-page commit
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_Atomic.hpp"
+
+#define W25Q64_ATOMIC_SECTOR_PAGES          (W25Q64_SECTOR_SIZE / W25Q64_PAGE_SIZE)
+#define W25Q64_ATOMIC_ROOT_SLOTS            (2 * W25Q64_ATOMIC_SECTOR_PAGES)
+
+W25Q64_status_t W25Q64_Atomic::init(W25Q64* flash, unsigned int root_sector, unsigned int pool_sector, unsigned int pool_sectors, unsigned int pages){
+    // live pages are never moved, a pool smaller than one sector per page can end up with a live page in every sector
+    if(pages > W25Q64_ATOMIC_MAX_PAGES || pool_sectors < 2 || pool_sectors < pages + 1) return W25Q64_INVALID_ADDRESS;
+    if(root_sector + 2 > W25Q64_SECTOR_COUNT || pool_sector + pool_sectors > W25Q64_SECTOR_COUNT) return W25Q64_INVALID_ADDRESS;
+    _flash = flash;
+    _root_sector = root_sector;
+    _pool_sector = pool_sector;
+    _pool_pages = pool_sectors * W25Q64_ATOMIC_SECTOR_PAGES;
+    _pages = pages;
+    _head = 0;
+    _head_ready = false;
+
+    // find the newest intact root record in either root sector
+    memset(&_committed, 0xFF, sizeof(_committed));
+    _committed.sequence = 0;
+    _root_slot = 0;
+    _root_ready = false;
+    bool found = false;
+    W25Q64_Atomic_root_t root;
+    _flash->waitWhileBusy();
+    for(unsigned int slot = 0; slot < W25Q64_ATOMIC_ROOT_SLOTS; slot ++){
+        _flash->fastRead(_root_sector * W25Q64_SECTOR_SIZE + slot * W25Q64_PAGE_SIZE, (byte*)&root, sizeof(root));
+        if(root.magic != W25Q64_ATOMIC_MAGIC) continue;
+        if(root.crc != W25Q64_crc32((byte*)&root, sizeof(root) - sizeof(root.crc))) continue;
+        if(found && root.sequence <= _committed.sequence) continue;
+        memcpy(&_committed, &root, sizeof(root));
+        _root_slot = slot + 1;
+        found = true;
+    }
+    // the rest of the current root sector was erased before the record was written, never reuse slots past a torn record
+    if(found && _root_slot % W25Q64_ATOMIC_SECTOR_PAGES != 0){
+        byte probe[sizeof(W25Q64_Atomic_root_t)];
+        _flash->fastRead(_root_sector * W25Q64_SECTOR_SIZE + _root_slot * W25Q64_PAGE_SIZE, probe, sizeof(probe));
+        _root_ready = true;
+        for(unsigned int i = 0; i < sizeof(probe); i ++){
+            if(probe[i] != 0xFF) _root_ready = false;
+        }
+        if(!_root_ready) _root_slot = (_root_slot / W25Q64_ATOMIC_SECTOR_PAGES + 1) * W25Q64_ATOMIC_SECTOR_PAGES;
+    }
+    _root_slot %= W25Q64_ATOMIC_ROOT_SLOTS;
+    for(unsigned int i = 0; i < W25Q64_ATOMIC_MAX_PAGES; i ++){
+        if(i >= _pages || _committed.table[i] >= _pool_pages) _committed.table[i] = W25Q64_ATOMIC_UNMAPPED;
+    }
+    abort();
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Atomic::read(unsigned int offset, byte* buff, unsigned int len){
+    if(offset + len > _pages * W25Q64_PAGE_SIZE) return W25Q64_INVALID_ADDRESS;
+    while(len > 0){
+        unsigned int page = offset / W25Q64_PAGE_SIZE;
+        unsigned int start = offset % W25Q64_PAGE_SIZE;
+        unsigned int chunk = W25Q64_PAGE_SIZE - start;
+        if(chunk > len) chunk = len;
+        if(_committed.table[page] == W25Q64_ATOMIC_UNMAPPED){
+            memset(buff, 0xFF, chunk);
+        }
+        else{
+            W25Q64_status_t status = _flash->fastRead(_poolAddress(_committed.table[page]) + start, buff, chunk);
+            if(status != W25Q64_OK) return status;
+        }
+        buff += chunk;
+        offset += chunk;
+        len -= chunk;
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Atomic::write(unsigned int offset, byte* buff, unsigned int len){
+    if(offset + len > _pages * W25Q64_PAGE_SIZE) return W25Q64_INVALID_ADDRESS;
+    W25Q64_status_t status = _prepareRoot();
+    if(status != W25Q64_OK) return status;
+    while(len > 0){
+        unsigned int page = offset / W25Q64_PAGE_SIZE;
+        unsigned int start = offset % W25Q64_PAGE_SIZE;
+        unsigned int chunk = W25Q64_PAGE_SIZE - start;
+        if(chunk > len) chunk = len;
+        // merge partial writes with the latest copy of the page
+        if(chunk < W25Q64_PAGE_SIZE){
+            if(_pending[page] == W25Q64_ATOMIC_UNMAPPED){
+                memset(_page, 0xFF, W25Q64_PAGE_SIZE);
+            }
+            else{
+                status = _flash->fastRead(_poolAddress(_pending[page]), _page, W25Q64_PAGE_SIZE);
+                if(status != W25Q64_OK) return status;
+            }
+        }
+        memcpy(_page + start, buff, chunk);
+        // never overwrite in place, shadow the page into free space
+        uint16_t shadow;
+        status = _allocate(&shadow);
+        if(status != W25Q64_OK) return status;
+        status = _program(_poolAddress(shadow), _page, W25Q64_PAGE_SIZE);
+        if(status != W25Q64_OK) return status;
+        _pending[page] = shadow;
+        buff += chunk;
+        offset += chunk;
+        len -= chunk;
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Atomic::commit(){
+    // normally already done by write(), keeping the commit itself to a single page program
+    W25Q64_status_t status = _prepareRoot();
+    if(status != W25Q64_OK) return status;
+    W25Q64_Atomic_root_t root;
+    memset(&root, 0xFF, sizeof(root));
+    root.magic = W25Q64_ATOMIC_MAGIC;
+    root.sequence = _committed.sequence + 1;
+    memcpy(root.table, _pending, sizeof(_pending));
+    root.crc = W25Q64_crc32((byte*)&root, sizeof(root) - sizeof(root.crc));
+    status = _program(_root_sector * W25Q64_SECTOR_SIZE + _root_slot * W25Q64_PAGE_SIZE, (byte*)&root, sizeof(root));
+    if(status != W25Q64_OK) return status;
+    memcpy(&_committed, &root, sizeof(root));
+    _root_slot = (_root_slot + 1) % W25Q64_ATOMIC_ROOT_SLOTS;
+    if(_root_slot % W25Q64_ATOMIC_SECTOR_PAGES == 0) _root_ready = false;
+    return W25Q64_OK;
+}
+
+void W25Q64_Atomic::abort(){
+    // pages written since the last commit are left behind, they are reclaimed when the pool wraps
+    memcpy(_pending, _committed.table, sizeof(_pending));
+}
+
+W25Q64_status_t W25Q64_Atomic::_prepareRoot(){
+    if(_root_ready) return W25Q64_OK;
+    // a fresh root sector must be erased before its first record, the other sector still holds the last commit
+    W25Q64_status_t status = _erase((_root_sector + _root_slot / W25Q64_ATOMIC_SECTOR_PAGES) * W25Q64_SECTOR_SIZE);
+    if(status != W25Q64_OK) return status;
+    _root_ready = true;
+    return W25Q64_OK;
+}
+
+bool W25Q64_Atomic::_live(unsigned int sector){
+    unsigned int first = sector * W25Q64_ATOMIC_SECTOR_PAGES;
+    unsigned int last = first + W25Q64_ATOMIC_SECTOR_PAGES;
+    for(unsigned int i = 0; i < _pages; i ++){
+        if(_committed.table[i] >= first && _committed.table[i] < last) return true;
+        if(_pending[i] >= first && _pending[i] < last) return true;
+    }
+    return false;
+}
+
+W25Q64_status_t W25Q64_Atomic::_allocate(uint16_t* page){
+    if(!_head_ready){
+        // walk the pool for a sector without live pages
+        unsigned int sectors = _pool_pages / W25Q64_ATOMIC_SECTOR_PAGES;
+        unsigned int sector = _head / W25Q64_ATOMIC_SECTOR_PAGES;
+        unsigned int tries = 0;
+        while(_live(sector)){
+            sector = (sector + 1) % sectors;
+            if(++ tries >= sectors) return W25Q64_FULL;
+        }
+        W25Q64_status_t status = _erase((_pool_sector + sector) * W25Q64_SECTOR_SIZE);
+        if(status != W25Q64_OK) return status;
+        _head = sector * W25Q64_ATOMIC_SECTOR_PAGES;
+        _head_ready = true;
+    }
+    *page = _head;
+    _head = (_head + 1) % _pool_pages;
+    if(_head % W25Q64_ATOMIC_SECTOR_PAGES == 0) _head_ready = false;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Atomic::_erase(unsigned int addr){
+    _flash->waitWhileBusy();
+    _flash->writeEnable();
+    W25Q64_status_t status = _flash->sectorErase(addr);
+    if(status != W25Q64_OK) return status;
+    return _flash->waitWhileBusy();
+}
+
+W25Q64_status_t W25Q64_Atomic::_program(unsigned int addr, byte* buff, unsigned int len){
+    _flash->writeEnable();
+    W25Q64_status_t status = _flash->pageProgram(addr, buff, len);
+    if(status != W25Q64_OK) return status;
+    return _flash->waitWhileBusy();
+}
@@ -0,0 +1,164 @@
+/**
+ * @file W25Q64_Atomic.hpp
+ * @author Jeremy Dunne
+ * @brief Power-loss safe atomic multi-page updates on the W25Q64 (shadow paging)
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_ATOMIC_HPP_
+#define _W25Q64_ATOMIC_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+#include "W25Q64_CRC.hpp"
+
+
+// atomic settings
+#define W25Q64_ATOMIC_MAX_PAGES             64 // max pages in the object, at most 120 so a root record fits a page
+#define W25Q64_ATOMIC_MAGIC                 0x544F4F52 // "ROOT"
+#define W25Q64_ATOMIC_UNMAPPED              0xFFFF
+
+#if W25Q64_ATOMIC_MAX_PAGES > 120
+#error "W25Q64_ATOMIC_MAX_PAGES too large for a single page root record"
+#endif
+
+/**
+ * @brief root record, one per commit
+ *
+ */
+typedef struct{
+    uint32_t magic;                             ///< W25Q64_ATOMIC_MAGIC
+    uint32_t sequence;                          ///< commit sequence, highest valid record wins
+    uint16_t table[W25Q64_ATOMIC_MAX_PAGES];    ///< logical page to pool page
+    uint32_t crc;                               ///< CRC32 of everything above
+} W25Q64_Atomic_root_t;
+
+/**
+ * @brief object stored with atomic multi-page commits
+ *
+ * Holds an object of up to W25Q64_ATOMIC_MAX_PAGES pages. Writes never touch the committed pages, they go to free pages
+ *  of a pool and are collected into a pending page table. commit() publishes the pending table with a single page
+ *  program of a root record carrying a sequence number and CRC. Root records are appended to one of two root sectors,
+ *  ping-ponging to the other once full, so after a power loss init() finds either the old or the new version, never a
+ *  mix of both.
+ *
+ */
+class W25Q64_Atomic{
+public:
+    /**
+     * @brief initialize and recover the last committed version
+     *
+     * @param flash initialized flash chip
+     * @param root_sector first of the two root sectors
+     * @param pool_sector first sector of the page pool
+     * @param pool_sectors number of sectors in the pool, at least pages + 1 so that committed pages spread one per sector
+     *  still leave a sector to write into
+     * @param pages size of the object in pages, at most W25Q64_ATOMIC_MAX_PAGES
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t init(W25Q64* flash, unsigned int root_sector, unsigned int pool_sector, unsigned int pool_sectors, unsigned int pages);
+
+    /**
+     * @brief read from the committed version of the object
+     *
+     * Pages never written read back as 0xFF
+     *
+     * @param offset byte offset within the object
+     * @param buff buffer to read into
+     * @param len number of bytes to read
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t read(unsigned int offset, byte* buff, unsigned int len);
+
+    /**
+     * @brief write into the pending version of the object
+     *
+     * Nothing is visible to read() or survives a reboot until commit()
+     *
+     * @param offset byte offset within the object
+     * @param buff buffer to write
+     * @param len number of bytes to write
+     * @return W25Q64_status_t W25Q64_FULL if the pool has no page free of live data, commit() or abort() to free pages
+     */
+    W25Q64_status_t write(unsigned int offset, byte* buff, unsigned int len);
+
+    /**
+     * @brief atomically publish the pending version
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t commit();
+
+    /**
+     * @brief drop the pending version
+     *
+     */
+    void abort();
+
+    /**
+     * @brief get the sequence number of the committed version
+     *
+     * @return uint32_t commit sequence, 0 if nothing has been committed
+     */
+    uint32_t sequence(){return _committed.sequence;};
+
+private:
+    W25Q64* _flash; ///< underlying chip
+    unsigned int _root_sector; ///< first of the two root sectors
+    unsigned int _pool_sector; ///< first pool sector
+    unsigned int _pool_pages; ///< pages in the pool
+    unsigned int _pages; ///< pages in the object
+    unsigned int _root_slot; ///< next root page to program, counted over both root sectors
+    bool _root_ready; ///< true if the root sector holding _root_slot is erased
+    unsigned int _head; ///< next pool page to program
+    bool _head_ready; ///< true if the sector holding _head is erased
+    W25Q64_Atomic_root_t _committed; ///< last committed root
+    uint16_t _pending[W25Q64_ATOMIC_MAX_PAGES]; ///< page table being built
+    byte _page[W25Q64_PAGE_SIZE]; ///< read-modify-write buffer
+
+    /**
+     * @brief get the chip address of a pool page
+     *
+     */
+    unsigned int _poolAddress(uint16_t page){
+        return _pool_sector * W25Q64_SECTOR_SIZE + (unsigned int)page * W25Q64_PAGE_SIZE;
+    };
+
+    /**
+     * @brief erase the root sector the next record goes to if needed
+     *
+     */
+    W25Q64_status_t _prepareRoot();
+
+    /**
+     * @brief check if a pool sector holds a page of the committed or pending version
+     *
+     */
+    bool _live(unsigned int sector);
+
+    /**
+     * @brief find the next pool page free of live data, erasing its sector on entry
+     *
+     */
+    W25Q64_status_t _allocate(uint16_t* page);
+
+    /**
+     * @brief erase a sector and wait for it
+     *
+     */
+    W25Q64_status_t _erase(unsigned int addr);
+
+    /**
+     * @brief program up to a page and wait for it
+     *
+     */
+    W25Q64_status_t _program(unsigned int addr, byte* buff, unsigned int len);
+};
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * @file W25Q64_CRC.hpp
+ * @author Jeremy Dunne
+ * @brief CRC32 used by the integrity checked layers on the W25Q64
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_CRC_HPP_
+#define _W25Q64_CRC_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+
+
+// CRC methods
+#define W25Q64_CRC32_BITWISE                0 // no table, 8 shifts per byte
+#define W25Q64_CRC32_TABLE                  1 // 1 KB table, one lookup per byte
+#define W25Q64_CRC32_SLICE8                 2 // 8 KB table, eight bytes per step
+#define W25Q64_CRC32_EXTERNAL               3 // W25Q64_crc32External() supplied by the application, e.g. a hardware CRC unit
+
+// CRC settings
+#ifndef W25Q64_CRC32_METHOD
+#if defined(__AVR__)
+#define W25Q64_CRC32_METHOD                 W25Q64_CRC32_BITWISE // tables would not fit in RAM
+#else
+#define W25Q64_CRC32_METHOD                 W25Q64_CRC32_SLICE8
+#endif
+#endif
+#define W25Q64_CRC32_POLYNOMIAL             0xEDB88320 // reflected IEEE 802.3 polynomial
+#define W25Q64_CRC32_INIT                   0xFFFFFFFF
+
+#if W25Q64_CRC32_METHOD == W25Q64_CRC32_EXTERNAL
+/**
+ * @brief application supplied CRC32 update, same contract as W25Q64_crc32Update
+ *
+ * Typically wraps a CRC peripheral or a ROM routine, e.g. ~esp_rom_crc32_le(~crc, buff, len) on the ESP32
+ *
+ */
+uint32_t W25Q64_crc32External(uint32_t crc, const byte* buff, unsigned int len);
+#endif
+
+/**
+ * @brief update a running CRC32
+ *
+ * Start from W25Q64_CRC32_INIT and invert the result once all the data has been added (same as zlib's crc32)
+ *
+ * @param crc running crc
+ * @param buff data to add
+ * @param len length of the data
+ * @return uint32_t updated running crc
+ */
+uint32_t W25Q64_crc32Update(uint32_t crc, const byte* buff, unsigned int len);
+
+/**
+ * @brief compute the CRC32 of a buffer
+ *
+ * @param buff data
+ * @param len length of the data
+ * @return uint32_t finished crc
+ */
+uint32_t W25Q64_crc32(const byte* buff, unsigned int len);
+
+/**
+ * @brief copy a buffer and add it to a running CRC32 in the same pass
+ *
+ * @param crc running crc
+ * @param dst destination
+ * @param src source
+ * @param len number of bytes
+ * @return uint32_t updated running crc
+ */
+uint32_t W25Q64_crc32Copy(uint32_t crc, byte* dst, const byte* src, unsigned int len);
+
+/**
+ * @brief fastRead and add the data read to a running CRC32
+ *
+ * @param flash initialized flash chip
+ * @param addr address to read from
+ * @param buff buffer to read into
+ * @param len number of bytes
+ * @param crc running crc to update
+ * @return W25Q64_status_t standard return type
+ */
+W25Q64_status_t W25Q64_crc32Read(W25Q64* flash, unsigned int addr, byte* buff, unsigned int len, uint32_t* crc);
+
+#endif
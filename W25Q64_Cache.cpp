@@ -0,0 +1,206 @@
+/**
+ * @file W25Q64_Cache.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 read cache
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_Cache.hpp"
+
+#define W25Q64_CACHE_LINE_MASK              (W25Q64_CACHE_LINE_SIZE - 1)
+#define W25Q64_CACHE_NO_TAG                 0xFFFFFFFF // never a line aligned address
+
+W25Q64_status_t W25Q64_Cache::init(W25Q64* flash, byte* arena, unsigned int size, W25Q64_Cache_policy_t policy){
+    // the bookkeeping goes first, align it
+    unsigned int skip = (sizeof(unsigned long) - (uintptr_t)arena % sizeof(unsigned long)) % sizeof(unsigned long);
+    if(size < skip) return W25Q64_INVALID_ARGUMENT;
+    arena += skip;
+    size -= skip;
+    _count = size / (sizeof(W25Q64_Cache_line_t) + 2 * sizeof(unsigned int) + W25Q64_CACHE_LINE_SIZE);
+    if(_count < 2) return W25Q64_INVALID_ARGUMENT;
+    _lines = (W25Q64_Cache_line_t*)arena;
+    _ghosts = (unsigned int*)(arena + _count * sizeof(W25Q64_Cache_line_t));
+    _data = (byte*)(_ghosts + 2 * _count);
+    _flash = flash;
+    _policy = policy;
+    _pinned = 0;
+    _hits = 0;
+    _misses = 0;
+    for(unsigned int i = 0; i < _count; i ++){
+        _lines[i].flags = 0;
+    }
+    invalidate();
+    flash->addObserver(this);
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Cache::read(unsigned int addr, byte* buff, unsigned int len){
+    if(addr + len > W25Q64_MAX_ADDRESS + 1) return W25Q64_INVALID_ADDRESS;
+    while(len > 0){
+        unsigned int offset = addr & W25Q64_CACHE_LINE_MASK;
+        unsigned int n = W25Q64_CACHE_LINE_SIZE - offset;
+        if(n > len) n = len;
+        int line = _lookup(addr - offset);
+        if(line < 0) return W25Q64_INVALID_ADDRESS;
+        memcpy(buff, &_data[line * W25Q64_CACHE_LINE_SIZE + offset], n);
+        addr += n;
+        buff += n;
+        len -= n;
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Cache::pin(unsigned int addr, unsigned int len){
+    if(addr + len > W25Q64_MAX_ADDRESS + 1) return W25Q64_INVALID_ADDRESS;
+    if(len == 0) return W25Q64_OK;
+    unsigned int first = addr & ~W25Q64_CACHE_LINE_MASK;
+    unsigned int last = (addr + len - 1) & ~W25Q64_CACHE_LINE_MASK;
+    // count the lines that are not pinned yet, at least one line has to stay free
+    unsigned int needed = (last - first) / W25Q64_CACHE_LINE_SIZE + 1;
+    for(unsigned int i = 0; i < _count; i ++){
+        if((_lines[i].flags & W25Q64_CACHE_PINNED) && _lines[i].addr >= first && _lines[i].addr <= last) needed --;
+    }
+    if(_pinned + needed >= _count) return W25Q64_FULL;
+    for(unsigned int line_addr = first; line_addr <= last; line_addr += W25Q64_CACHE_LINE_SIZE){
+        int line = _lookup(line_addr);
+        if(line < 0) return W25Q64_INVALID_ADDRESS;
+        if(!(_lines[line].flags & W25Q64_CACHE_PINNED)){
+            _lines[line].flags |= W25Q64_CACHE_PINNED;
+            _pinned ++;
+        }
+    }
+    return W25Q64_OK;
+}
+
+void W25Q64_Cache::unpin(unsigned int addr, unsigned int len){
+    for(unsigned int i = 0; i < _count; i ++){
+        if(!(_lines[i].flags & W25Q64_CACHE_PINNED)) continue;
+        if(_lines[i].addr + W25Q64_CACHE_LINE_SIZE <= addr || _lines[i].addr >= addr + len) continue;
+        _lines[i].flags &= ~W25Q64_CACHE_PINNED;
+        _pinned --;
+    }
+}
+
+void W25Q64_Cache::mutated(W25Q64_mutation_t kind, unsigned int addr, const byte* data, unsigned int len){
+    if(kind == W25Q64_MUTATION_PROGRAM) _programmed(addr, data, len);
+    else _erased(addr, len);
+}
+
+void W25Q64_Cache::invalidate(){
+    for(unsigned int i = 0; i < _count; i ++){
+        if(!(_lines[i].flags & W25Q64_CACHE_PINNED)) _lines[i].flags = 0;
+    }
+    for(unsigned int i = 0; i < 2 * _count; i ++){
+        _ghosts[i] = W25Q64_CACHE_NO_TAG;
+    }
+    _clock = 0;
+    _hand = 0;
+    _target = _count / 2;
+    _ghost_next[0] = 0;
+    _ghost_next[1] = 0;
+}
+
+int W25Q64_Cache::_lookup(unsigned int addr){
+    for(unsigned int i = 0; i < _count; i ++){
+        if((_lines[i].flags & W25Q64_CACHE_VALID) && _lines[i].addr == addr){
+            _hits ++;
+            _lines[i].used = ++ _clock;
+            // a second hit moves an ARC line from T1 to T2
+            _lines[i].flags |= W25Q64_CACHE_REFERENCED | W25Q64_CACHE_FREQUENT;
+            return i;
+        }
+    }
+    _misses ++;
+    bool frequent = false;
+    if(_policy == W25Q64_CACHE_ARC){
+        // a miss on a line T1 just lost means T1 is too small, on one T2 just lost that T2 is
+        if(_ghostHit(0, addr)){
+            if(_target < _count) _target ++;
+            frequent = true;
+        }
+        else if(_ghostHit(1, addr)){
+            if(_target > 0) _target --;
+            frequent = true;
+        }
+    }
+    int line = _victim();
+    if(line < 0) return -1;
+    _lines[line].flags = 0;
+    _flash->waitWhileBusy();
+    if(_flash->fastRead(addr, &_data[line * W25Q64_CACHE_LINE_SIZE], W25Q64_CACHE_LINE_SIZE) != W25Q64_OK) return -1;
+    _lines[line].addr = addr;
+    _lines[line].used = ++ _clock;
+    _lines[line].flags = W25Q64_CACHE_VALID | (frequent ? W25Q64_CACHE_FREQUENT : 0);
+    return line;
+}
+
+int W25Q64_Cache::_victim(){
+    for(unsigned int i = 0; i < _count; i ++){
+        if(!(_lines[i].flags & W25Q64_CACHE_VALID)) return i;
+    }
+    if(_policy == W25Q64_CACHE_CLOCK){
+        // two turns clear every reference bit, so an unpinned line is found if there is one
+        for(unsigned int n = 0; n < 2 * _count; n ++){
+            unsigned int i = _hand;
+            _hand = (_hand + 1) % _count;
+            if(_lines[i].flags & W25Q64_CACHE_PINNED) continue;
+            if(_lines[i].flags & W25Q64_CACHE_REFERENCED){
+                _lines[i].flags &= ~W25Q64_CACHE_REFERENCED;
+                continue;
+            }
+            return i;
+        }
+        return -1;
+    }
+    // least recently used line overall (LRU) or of each ARC list
+    int oldest[2] = {-1, -1};
+    unsigned int recent = 0;
+    for(unsigned int i = 0; i < _count; i ++){
+        unsigned int list = (_policy == W25Q64_CACHE_ARC && (_lines[i].flags & W25Q64_CACHE_FREQUENT)) ? 1 : 0;
+        if(list == 0) recent ++;
+        if(_lines[i].flags & W25Q64_CACHE_PINNED) continue;
+        if(oldest[list] < 0 || _lines[i].used < _lines[oldest[list]].used) oldest[list] = i;
+    }
+    if(_policy == W25Q64_CACHE_LRU) return oldest[0];
+    unsigned int list = (recent > _target || oldest[1] < 0) ? 0 : 1;
+    if(oldest[list] < 0) list ^= 1;
+    if(oldest[list] < 0) return -1;
+    _ghosts[list * _count + _ghost_next[list]] = _lines[oldest[list]].addr;
+    _ghost_next[list] = (_ghost_next[list] + 1) % _count;
+    return oldest[list];
+}
+
+bool W25Q64_Cache::_ghostHit(unsigned int list, unsigned int addr){
+    unsigned int* ghosts = &_ghosts[list * _count];
+    for(unsigned int i = 0; i < _count; i ++){
+        if(ghosts[i] == addr){
+            ghosts[i] = W25Q64_CACHE_NO_TAG;
+            return true;
+        }
+    }
+    return false;
+}
+
+void W25Q64_Cache::_programmed(unsigned int addr, const byte* buff, unsigned int len){
+    for(unsigned int i = 0; i < _count; i ++){
+        if(!(_lines[i].flags & W25Q64_CACHE_VALID)) continue;
+        unsigned int start = _lines[i].addr > addr ? _lines[i].addr : addr;
+        unsigned int end = _lines[i].addr + W25Q64_CACHE_LINE_SIZE < addr + len ? _lines[i].addr + W25Q64_CACHE_LINE_SIZE : addr + len;
+        // programming only clears bits, the cached copy follows the chip
+        for(unsigned int a = start; a < end; a ++){
+            _data[i * W25Q64_CACHE_LINE_SIZE + (a - _lines[i].addr)] &= buff[a - addr];
+        }
+    }
+}
+
+void W25Q64_Cache::_erased(unsigned int addr, unsigned int len){
+    for(unsigned int i = 0; i < _count; i ++){
+        if(!(_lines[i].flags & W25Q64_CACHE_VALID)) continue;
+        if(_lines[i].addr + W25Q64_CACHE_LINE_SIZE <= addr || _lines[i].addr >= addr + len) continue;
+        memset(&_data[i * W25Q64_CACHE_LINE_SIZE], 0xFF, W25Q64_CACHE_LINE_SIZE);
+    }
+}
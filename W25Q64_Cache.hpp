@@ -0,0 +1,192 @@
+/**
+ * @file W25Q64_Cache.hpp
+ * @author Jeremy Dunne
+ * @brief Read cache for the W25Q64 with selectable replacement and pinning
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_CACHE_HPP_
+#define _W25Q64_CACHE_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+
+
+// cache settings
+#define W25Q64_CACHE_LINE_SIZE              64 // bytes per line, a power of two up to the page size
+
+// line flags
+#define W25Q64_CACHE_VALID                  0x01 // line holds data
+#define W25Q64_CACHE_PINNED                 0x02 // line is never evicted
+#define W25Q64_CACHE_REFERENCED             0x04 // CLOCK reference bit
+#define W25Q64_CACHE_FREQUENT               0x08 // ARC line hit more than once (T2)
+
+/**
+ * @brief replacement policies
+ *
+ */
+typedef enum{
+    W25Q64_CACHE_LRU = 0,       ///< evict the least recently used line
+    W25Q64_CACHE_CLOCK,         ///< second chance sweep over reference bits
+    W25Q64_CACHE_ARC            ///< recency and frequency lists balanced by ghost hits
+} W25Q64_Cache_policy_t;
+
+/**
+ * @brief line bookkeeping, kept at the front of the arena
+ *
+ */
+typedef struct{
+    unsigned int addr;          ///< line aligned chip address held
+    unsigned long used;         ///< access count of the last use
+    uint8_t flags;              ///< W25Q64_CACHE_ flags
+} W25Q64_Cache_line_t;
+
+/**
+ * @brief fully associative read cache in a caller supplied arena
+ *
+ * The arena is split into as many W25Q64_CACHE_LINE_SIZE lines as fit, together with their bookkeeping, so the cache
+ *  costs no memory until it is set up. The replacement policy is picked at init:
+ *
+ *  LRU evicts the line used longest ago. CLOCK sweeps a hand over the lines, clearing reference bits and evicting the
+ *  first line found without one. ARC keeps lines seen once (T1) apart from lines hit again (T2), remembers the tags of
+ *  recently evicted lines of both and shifts the share of T1 towards whichever list a miss turns up in, so a long scan
+ *  can not flush the hot set.
+ *
+ *  Pinned lines are never evicted. The cache observes the chip, every program or erase sent to it by any path is applied
+ *  to the cached copies (a program ANDs the data in like the chip does, an erase sets 0xFF), so lines never go stale and
+ *  pinned lines stay valid.
+ *
+ */
+class W25Q64_Cache : public W25Q64_Observer{
+public:
+    /**
+     * @brief set up the cache and start observing the chip
+     *
+     * @param flash initialized flash chip
+     * @param arena memory for the lines
+     * @param size bytes of arena
+     * @param policy replacement policy
+     * @return W25Q64_status_t W25Q64_INVALID_ARGUMENT if the arena does not hold two lines
+     */
+    W25Q64_status_t init(W25Q64* flash, byte* arena, unsigned int size, W25Q64_Cache_policy_t policy);
+
+    /**
+     * @brief read through the cache
+     *
+     * @param addr address to read from
+     * @param buff buffer to read into
+     * @param len number of bytes
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t read(unsigned int addr, byte* buff, unsigned int len);
+
+    /**
+     * @brief load a range and keep it cached until unpinned
+     *
+     * @param addr start of the range
+     * @param len length of the range
+     * @return W25Q64_status_t W25Q64_FULL if pinning it would leave no line to cache anything else in
+     */
+    W25Q64_status_t pin(unsigned int addr, unsigned int len);
+
+    /**
+     * @brief let a pinned range be evicted again
+     *
+     * @param addr start of the range
+     * @param len length of the range
+     */
+    void unpin(unsigned int addr, unsigned int len);
+
+    /**
+     * @brief apply a program or erase to the cached copies, called by the chip
+     *
+     * @param kind what happened to the range
+     * @param addr start of the range
+     * @param data bytes programmed, NULL for an erase
+     * @param len length of the range
+     */
+    void mutated(W25Q64_mutation_t kind, unsigned int addr, const byte* data, unsigned int len);
+
+    /**
+     * @brief drop every line that is not pinned
+     *
+     */
+    void invalidate();
+
+    /**
+     * @brief get the number of lines the arena holds
+     *
+     * @return unsigned int lines
+     */
+    unsigned int lines(){return _count;};
+
+    /**
+     * @brief get the number of line lookups served from the cache
+     *
+     * @return unsigned long hits
+     */
+    unsigned long hits(){return _hits;};
+
+    /**
+     * @brief get the number of line lookups that read the chip
+     *
+     * @return unsigned long misses
+     */
+    unsigned long misses(){return _misses;};
+
+private:
+    W25Q64* _flash; ///< flash chip used
+    W25Q64_Cache_policy_t _policy; ///< replacement policy
+    W25Q64_Cache_line_t* _lines; ///< line bookkeeping, in the arena
+    byte* _data; ///< line data, in the arena
+    unsigned int* _ghosts; ///< ARC tags of evicted T1 lines (B1) then T2 lines (B2), in the arena
+    unsigned int _count; ///< number of lines
+    unsigned int _pinned; ///< lines pinned
+    unsigned long _clock; ///< access counter
+    unsigned int _hand; ///< CLOCK hand
+    unsigned int _target; ///< ARC target number of T1 lines
+    unsigned int _ghost_next[2]; ///< next slot written in B1 and B2
+    unsigned long _hits; ///< lookups served from the cache
+    unsigned long _misses; ///< lookups that read the chip
+
+    /**
+     * @brief find a line, reading it in on a miss
+     *
+     * @return int index of the line, -1 if it could not be read
+     */
+    int _lookup(unsigned int addr);
+
+    /**
+     * @brief pick the line to replace by the policy
+     *
+     * @return int index of the line, -1 if every line is pinned
+     */
+    int _victim();
+
+    /**
+     * @brief check and remove a tag from an ARC ghost list
+     *
+     * @param list 0 for B1, 1 for B2
+     */
+    bool _ghostHit(unsigned int list, unsigned int addr);
+
+    /**
+     * @brief apply a program to the cached copies
+     *
+     */
+    void _programmed(unsigned int addr, const byte* buff, unsigned int len);
+
+    /**
+     * @brief apply an erase to the cached copies
+     *
+     */
+    void _erased(unsigned int addr, unsigned int len);
+};
+
+#endif
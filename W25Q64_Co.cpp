@@ -0,0 +1,111 @@
+/**
+ * @file W25Q64_Co.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 coroutine interface
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_Co.hpp"
+
+#if defined(__cpp_impl_coroutine)
+
+W25Q64_CoOp::W25Q64_CoOp(W25Q64_CoFlash* owner, W25Q64_Co_op_t type, unsigned int addr, byte* buff, unsigned int len){
+    _owner = owner;
+    _type = type;
+    _addr = addr;
+    _buff = buff;
+    _len = len;
+    _started = false;
+    _done = false;
+    _status = W25Q64_OK;
+    _next = NULL;
+    // refuse bad ranges without suspending
+    if(addr + len > W25Q64_MAX_ADDRESS + 1){
+        _status = W25Q64_INVALID_ADDRESS;
+        _done = true;
+    }
+}
+
+void W25Q64_CoOp::await_suspend(std::coroutine_handle<> handle){
+    _handle = handle;
+    _owner->_append(this);
+}
+
+bool W25Q64_CoOp::_step(W25Q64* flash){
+    switch(_type){
+        case W25Q64_CO_READ:
+            _status = flash->fastRead(_addr, _buff, _len);
+            return true;
+        case W25Q64_CO_ERASE:
+            // the second turn after the erase was sent means the chip finished it
+            if(_started) return true;
+            _started = true;
+            flash->writeEnable();
+            _status = flash->sectorErase(_addr);
+            return _status != W25Q64_OK;
+        case W25Q64_CO_WRITE:{
+            if(_len == 0) return true;
+            unsigned int n = W25Q64_PAGE_SIZE - _addr % W25Q64_PAGE_SIZE;
+            if(n > _len) n = _len;
+            flash->writeEnable();
+            _status = flash->pageProgram(_addr, _buff, n);
+            if(_status != W25Q64_OK) return true;
+            _addr += n;
+            _buff += n;
+            _len -= n;
+            return false;
+        }
+    }
+    return true;
+}
+
+W25Q64_status_t W25Q64_CoFlash::init(W25Q64* flash){
+    _flash = flash;
+    _head = NULL;
+    _tail = NULL;
+    _waiting = 0;
+    return W25Q64_OK;
+}
+
+W25Q64_CoOp W25Q64_CoFlash::read(unsigned int addr, byte* buff, unsigned int len){
+    return W25Q64_CoOp(this, W25Q64_CO_READ, addr, buff, len);
+}
+
+W25Q64_CoOp W25Q64_CoFlash::write(unsigned int addr, byte* buff, unsigned int len){
+    return W25Q64_CoOp(this, W25Q64_CO_WRITE, addr, buff, len);
+}
+
+W25Q64_CoOp W25Q64_CoFlash::erase(unsigned int addr){
+    return W25Q64_CoOp(this, W25Q64_CO_ERASE, addr - addr % W25Q64_SECTOR_SIZE, NULL, 0);
+}
+
+W25Q64_status_t W25Q64_CoFlash::poll(){
+    if(_head == NULL) return W25Q64_OK;
+    if(_flash->busy()) return W25Q64_BUSY;
+    // unlink first, the resumed coroutine may queue its next operation straight away
+    W25Q64_CoOp* op = _head;
+    _head = op->_next;
+    if(_head == NULL) _tail = NULL;
+    _waiting --;
+    if(op->_step(_flash)){
+        op->_handle.resume();
+    }
+    else{
+        _append(op);
+    }
+    return _head == NULL ? W25Q64_OK : W25Q64_BUSY;
+}
+
+void W25Q64_CoFlash::_append(W25Q64_CoOp* op){
+    op->_next = NULL;
+    if(_tail == NULL) _head = op;
+    else _tail->_next = op;
+    _tail = op;
+    _waiting ++;
+}
+
+#endif
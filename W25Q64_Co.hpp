@@ -0,0 +1,171 @@
+/**
+ * @file W25Q64_Co.hpp
+ * @author Jeremy Dunne
+ * @brief C++20 coroutine interface for the W25Q64
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_CO_HPP_
+#define _W25Q64_CO_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+
+// only built by compilers with coroutine support (C++20)
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+
+
+/**
+ * @brief kinds of awaitable operation
+ *
+ */
+typedef enum{
+    W25Q64_CO_READ = 0,         ///< fast read
+    W25Q64_CO_WRITE,            ///< program erased memory, any length and alignment
+    W25Q64_CO_ERASE             ///< sector erase
+} W25Q64_Co_op_t;
+
+/**
+ * @brief fire and forget coroutine return type
+ *
+ * A coroutine returning W25Q64_CoTask starts running straight away and frees its frame when it returns
+ *
+ */
+class W25Q64_CoTask{
+public:
+    class promise_type{
+    public:
+        W25Q64_CoTask get_return_object(){return W25Q64_CoTask();};
+        std::suspend_never initial_suspend() noexcept {return std::suspend_never();};
+        std::suspend_never final_suspend() noexcept {return std::suspend_never();};
+        void return_void(){};
+        void unhandled_exception(){};
+    };
+};
+
+class W25Q64_CoFlash;
+
+/**
+ * @brief operation returned by W25Q64_CoFlash, co_await it for the W25Q64_status_t
+ *
+ * Lives in the awaiting coroutine's frame while it is suspended and is linked into the owner's wait list from there, so
+ *  waiting costs no allocation
+ *
+ */
+class W25Q64_CoOp{
+public:
+    bool await_ready(){return _done;};
+    void await_suspend(std::coroutine_handle<> handle);
+    W25Q64_status_t await_resume(){return _status;};
+
+private:
+    friend class W25Q64_CoFlash;
+
+    W25Q64_CoFlash* _owner; ///< flash the operation runs on
+    W25Q64_Co_op_t _type; ///< kind of operation
+    unsigned int _addr; ///< next address to work on
+    byte* _buff; ///< next byte to read or program
+    unsigned int _len; ///< bytes left
+    bool _started; ///< erase has been sent
+    bool _done; ///< finished or refused before suspending
+    W25Q64_status_t _status; ///< result handed to the coroutine
+    std::coroutine_handle<> _handle; ///< coroutine to resume
+    W25Q64_CoOp* _next; ///< next operation in the wait list
+
+    W25Q64_CoOp(W25Q64_CoFlash* owner, W25Q64_Co_op_t type, unsigned int addr, byte* buff, unsigned int len);
+
+    /**
+     * @brief do the next piece of work, the chip is idle
+     *
+     * @return bool true once the operation is finished
+     */
+    bool _step(W25Q64* flash);
+};
+
+/**
+ * @brief awaitable access to one chip for many coroutines
+ *
+ * read(), write() and erase() suspend the calling coroutine instead of spinning on busy(). The event loop calls poll(),
+ *  which checks the chip's status once and, if it is idle, gives the operation at the front of the wait list its next
+ *  piece of work: a read, one page program or the erase command. An operation that is not finished goes to the back of
+ *  the list, so a read waiting behind a long write is served between its pages. A coroutine is resumed from poll() when
+ *  its operation is done.
+ *
+ */
+class W25Q64_CoFlash{
+public:
+    /**
+     * @brief set up the wrapper
+     *
+     * @param flash initialized flash chip
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t init(W25Q64* flash);
+
+    /**
+     * @brief read data
+     *
+     * @param addr address to read from
+     * @param buff buffer to read into, must stay valid until resumed
+     * @param len number of bytes
+     * @return W25Q64_CoOp operation to co_await
+     */
+    W25Q64_CoOp read(unsigned int addr, byte* buff, unsigned int len);
+
+    /**
+     * @brief program erased memory
+     *
+     * @param addr address to program
+     * @param buff data to program, must stay valid until resumed
+     * @param len number of bytes
+     * @return W25Q64_CoOp operation to co_await
+     */
+    W25Q64_CoOp write(unsigned int addr, byte* buff, unsigned int len);
+
+    /**
+     * @brief erase a sector
+     *
+     * @param addr address in the sector
+     * @return W25Q64_CoOp operation to co_await
+     */
+    W25Q64_CoOp erase(unsigned int addr);
+
+    /**
+     * @brief move the operations on, call from the event loop
+     *
+     * @return W25Q64_status_t W25Q64_BUSY while operations are waiting
+     */
+    W25Q64_status_t poll();
+
+    /**
+     * @brief get the number of suspended operations
+     *
+     * @return unsigned int operations waiting
+     */
+    unsigned int waiting(){return _waiting;};
+
+private:
+    friend class W25Q64_CoOp;
+
+    W25Q64* _flash; ///< flash chip used
+    W25Q64_CoOp* _head; ///< front of the wait list
+    W25Q64_CoOp* _tail; ///< back of the wait list
+    unsigned int _waiting; ///< operations in the wait list
+
+    /**
+     * @brief add an operation to the back of the wait list
+     *
+     */
+    void _append(W25Q64_CoOp* op);
+};
+
+#endif
+
+#endif
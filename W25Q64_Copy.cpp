@@ -0,0 +1,43 @@
+/**
+ * @file W25Q64_Copy.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 flash to flash copy
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_Copy.hpp"
+
+W25Q64_status_t W25Q64_copy(W25Q64* src_flash, unsigned int src, W25Q64* dst_flash, unsigned int dst, unsigned int len, uint32_t* crc){
+    if(src + len > W25Q64_MAX_ADDRESS + 1 || dst + len > W25Q64_MAX_ADDRESS + 1) return W25Q64_INVALID_ADDRESS;
+    if(src_flash == dst_flash && src < dst + len && dst < src + len) return W25Q64_INVALID_ARGUMENT;
+    uint32_t running = W25Q64_CRC32_INIT;
+    byte buff[W25Q64_PAGE_SIZE];
+    // chunks follow the destination pages so every program is a single command
+    unsigned int n = W25Q64_PAGE_SIZE - dst % W25Q64_PAGE_SIZE;
+    if(n > len) n = len;
+    src_flash->waitWhileBusy();
+    W25Q64_status_t status = src_flash->fastRead(src, buff, n);
+    while(len > 0){
+        if(status != W25Q64_OK) return status;
+        dst_flash->waitWhileBusy();
+        dst_flash->writeEnable();
+        status = dst_flash->pageProgram(dst, buff, n);
+        if(status != W25Q64_OK) return status;
+        // the page has been sent, the buffer is free again while the chip programs it
+        if(crc != NULL) running = W25Q64_crc32Update(running, buff, n);
+        src += n;
+        dst += n;
+        len -= n;
+        n = len < W25Q64_PAGE_SIZE ? len : W25Q64_PAGE_SIZE;
+        if(len > 0){
+            src_flash->waitWhileBusy();
+            status = src_flash->fastRead(src, buff, n);
+        }
+    }
+    if(crc != NULL) *crc = ~running;
+    return dst_flash->waitWhileBusy();
+}
@@ -0,0 +1,39 @@
+/**
+ * @file W25Q64_Copy.hpp
+ * @author Jeremy Dunne
+ * @brief Flash to flash copy for the W25Q64
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_COPY_HPP_
+#define _W25Q64_COPY_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+#include "W25Q64_CRC.hpp"
+
+
+/**
+ * @brief copy a range within a chip or from one chip to another
+ *
+ * Uses one page of stack. The data is moved a destination page at a time: the page is read, its program is started and,
+ *  while the destination chip is in tPP, the CRC is updated and, when the source is another chip, the next page is
+ *  already read from it. On a single chip the read has to wait for the program, so there only the CRC overlaps.
+ *
+ * @param src_flash chip to copy from
+ * @param src address to copy from
+ * @param dst_flash chip to copy to, may be src_flash
+ * @param dst address to copy to, must be erased
+ * @param len number of bytes, any alignment
+ * @param crc set to the W25Q64_crc32 of the data copied, NULL to skip it
+ * @return W25Q64_status_t W25Q64_INVALID_ARGUMENT if the ranges overlap on the same chip
+ */
+W25Q64_status_t W25Q64_copy(W25Q64* src_flash, unsigned int src, W25Q64* dst_flash, unsigned int dst, unsigned int len, uint32_t* crc);
+
+#endif
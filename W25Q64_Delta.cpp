@@ -0,0 +1,332 @@
+/**
+ * @file W25Q64_Delta.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 delta compressed record log
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_Delta.hpp"
+
+#define W25Q64_DELTA_SECTOR_PAGES           (W25Q64_SECTOR_SIZE / W25Q64_PAGE_SIZE)
+#define W25Q64_DELTA_GROUP                  7 // fields per mask byte
+
+// delta codec \\
+
+W25Q64_status_t W25Q64_DeltaCodec::init(const byte* field_sizes, unsigned int field_count){
+    if(field_count == 0 || field_count > W25Q64_DELTA_MAX_FIELDS) return W25Q64_INVALID_ARGUMENT;
+    _field_count = field_count;
+    _record_size = 0;
+    for(unsigned int i = 0; i < field_count; i ++){
+        if(field_sizes[i] != 1 && field_sizes[i] != 2 && field_sizes[i] != 4) return W25Q64_INVALID_ARGUMENT;
+        _field_sizes[i] = field_sizes[i];
+        _record_size += field_sizes[i];
+    }
+    if(_record_size > W25Q64_DELTA_MAX_RECORD) return W25Q64_INVALID_ARGUMENT;
+    reset();
+    return W25Q64_OK;
+}
+
+void W25Q64_DeltaCodec::reset(){
+    memset(_previous, 0, sizeof(_previous));
+}
+
+unsigned int W25Q64_DeltaCodec::encode(const byte* record, byte* out){
+    unsigned int n = 0;
+    unsigned int offset = 0;
+    unsigned int mask_at = 0;
+    for(unsigned int i = 0; i < _field_count; i ++){
+        if(i % W25Q64_DELTA_GROUP == 0){
+            mask_at = n ++;
+            out[mask_at] = 0;
+        }
+        unsigned int width = _field_sizes[i];
+        uint32_t current = 0, previous = 0;
+        for(unsigned int b = 0; b < width; b ++){
+            current |= (uint32_t)record[offset + b] << (8 * b);
+            previous |= (uint32_t)_previous[offset + b] << (8 * b);
+        }
+        offset += width;
+        // difference in the field's own width, sign extended and zigzag mapped
+        uint32_t delta = current - previous;
+        if(width < 4){
+            uint32_t sign = (uint32_t)1 << (8 * width - 1);
+            delta &= (sign << 1) - 1;
+            delta = (delta ^ sign) - sign;
+        }
+        uint32_t zigzag = (delta << 1) ^ (uint32_t)((int32_t)delta >> 31);
+        if(zigzag == 0) continue;
+        out[mask_at] |= 1 << (i % W25Q64_DELTA_GROUP);
+        while(zigzag >= 0x80){
+            out[n ++] = (byte)(zigzag | 0x80);
+            zigzag >>= 7;
+        }
+        out[n ++] = (byte)zigzag;
+    }
+    memcpy(_previous, record, _record_size);
+    return n;
+}
+
+unsigned int W25Q64_DeltaCodec::decode(const byte* in, unsigned int len, byte* record){
+    unsigned int n = 0;
+    unsigned int offset = 0;
+    byte mask = 0;
+    for(unsigned int i = 0; i < _field_count; i ++){
+        if(i % W25Q64_DELTA_GROUP == 0){
+            if(n >= len) return 0;
+            mask = in[n ++];
+            if(mask & 0x80) return 0;
+        }
+        unsigned int width = _field_sizes[i];
+        uint32_t zigzag = 0;
+        if(mask & (1 << (i % W25Q64_DELTA_GROUP))){
+            for(unsigned int shift = 0; ; shift += 7){
+                if(n >= len || shift > 28) return 0;
+                byte b = in[n ++];
+                zigzag |= (uint32_t)(b & 0x7F) << shift;
+                if(!(b & 0x80)) break;
+            }
+        }
+        uint32_t previous = 0;
+        for(unsigned int b = 0; b < width; b ++){
+            previous |= (uint32_t)_previous[offset + b] << (8 * b);
+        }
+        uint32_t current = previous + ((zigzag >> 1) ^ (0 - (zigzag & 1)));
+        for(unsigned int b = 0; b < width; b ++){
+            record[offset + b] = (byte)(current >> (8 * b));
+        }
+        offset += width;
+    }
+    memcpy(_previous, record, _record_size);
+    return n;
+}
+
+unsigned int W25Q64_DeltaCodec::maxEncodedSize(){
+    unsigned int size = (_field_count + W25Q64_DELTA_GROUP - 1) / W25Q64_DELTA_GROUP;
+    for(unsigned int i = 0; i < _field_count; i ++){
+        // a zigzag value of 8 * width bits takes this many 7-bit groups
+        size += (8 * _field_sizes[i] + 6) / 7;
+    }
+    return size;
+}
+
+// delta log \\
+
+W25Q64_status_t W25Q64_DeltaLog::init(W25Q64* flash, unsigned int first_sector, unsigned int sector_count, const byte* field_sizes, unsigned int field_count){
+    if(sector_count < 2 || sector_count > W25Q64_DELTA_MAX_SECTORS) return W25Q64_INVALID_ADDRESS;
+    if(first_sector + sector_count > W25Q64_SECTOR_COUNT) return W25Q64_INVALID_ADDRESS;
+    W25Q64_status_t status = _codec.init(field_sizes, field_count);
+    if(status != W25Q64_OK) return status;
+    _flash = flash;
+    _first_sector = first_sector;
+    _sector_count = sector_count;
+    _oldest = 0;
+    _used = 0;
+    _sequence = 0;
+    _page = 0;
+    _fill = 0;
+    _programmed = 0;
+    _raw_bytes = 0;
+    _encoded_bytes = 0;
+    _flash->waitWhileBusy();
+
+    // the newest sector is the one with the highest sequence
+    uint32_t header[2];
+    bool found = false;
+    unsigned int newest = 0;
+    for(unsigned int sector = 0; sector < _sector_count; sector ++){
+        _flash->fastRead(_pageAddress(sector, 0), (byte*)header, sizeof(header));
+        if(header[0] != W25Q64_DELTA_MAGIC) continue;
+        if(!found || header[1] > _sequence){
+            _sequence = header[1];
+            newest = sector;
+            found = true;
+        }
+    }
+    if(!found) return W25Q64_OK;
+
+    // walk back over the run of consecutive sequences to the oldest sector
+    _used = 1;
+    _oldest = newest;
+    while(_used < _sector_count){
+        unsigned int previous = (_oldest + _sector_count - 1) % _sector_count;
+        _flash->fastRead(_pageAddress(previous, 0), (byte*)header, sizeof(header));
+        if(header[0] != W25Q64_DELTA_MAGIC || header[1] != _sequence - _used) break;
+        _oldest = previous;
+        _used ++;
+    }
+
+    // the page being filled is the last one holding records, replay it to restore the encoder state
+    byte record[W25Q64_DELTA_MAX_RECORD];
+    for(unsigned int page = W25Q64_DELTA_SECTOR_PAGES; page > 0; page --){
+        _flash->fastRead(_pageAddress(newest, page - 1), _image, W25Q64_PAGE_SIZE);
+        if(_image[_pageStart(page - 1)] != W25Q64_DELTA_END || page == 1){
+            _page = page - 1;
+            break;
+        }
+    }
+    _codec.reset();
+    _fill = _pageStart(_page);
+    while(_fill < W25Q64_PAGE_SIZE && _image[_fill] != W25Q64_DELTA_END){
+        unsigned int n = _codec.decode(_image + _fill, W25Q64_PAGE_SIZE - _fill, record);
+        if(n == 0) break;
+        _fill += n;
+    }
+    // anything past the last good record is unusable until the next page
+    _programmed = _fill;
+    if(_fill < W25Q64_PAGE_SIZE && _image[_fill] != W25Q64_DELTA_END) _fill = _programmed = W25Q64_PAGE_SIZE;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_DeltaLog::clear(){
+    for(unsigned int position = 0; position < _used; position ++){
+        unsigned int sector = (_oldest + position) % _sector_count;
+        _flash->waitWhileBusy();
+        _flash->writeEnable();
+        W25Q64_status_t status = _flash->sectorErase(_pageAddress(sector, 0));
+        if(status != W25Q64_OK) return status;
+    }
+    _flash->waitWhileBusy();
+    _oldest = (_oldest + _used) % _sector_count;
+    _used = 0;
+    _page = 0;
+    _fill = 0;
+    _programmed = 0;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_DeltaLog::append(const byte* record){
+    W25Q64_status_t status;
+    if(_used == 0){
+        status = _open();
+        if(status != W25Q64_OK) return status;
+    }
+    // encode on a copy first, a record that does not fit is re-encoded against a fresh page
+    byte encoded[W25Q64_DELTA_MAX_RECORD * 2];
+    W25Q64_DeltaCodec trial = _codec;
+    unsigned int n = trial.encode(record, encoded);
+    if(_fill + n > W25Q64_PAGE_SIZE){
+        status = flush();
+        if(status != W25Q64_OK) return status;
+        _page ++;
+        if(_page >= W25Q64_DELTA_SECTOR_PAGES){
+            status = _open();
+            if(status != W25Q64_OK) return status;
+        }
+        else{
+            memset(_image, 0xFF, W25Q64_PAGE_SIZE);
+            _fill = 0;
+            _programmed = 0;
+            _codec.reset();
+        }
+        trial = _codec;
+        n = trial.encode(record, encoded);
+    }
+    _codec = trial;
+    memcpy(_image + _fill, encoded, n);
+    _fill += n;
+    _raw_bytes += _codec.recordSize();
+    _encoded_bytes += n;
+    // program once the page is full, partial pages wait for more records or flush()
+    if(_fill >= W25Q64_PAGE_SIZE) return flush();
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_DeltaLog::flush(){
+    if(_used == 0 || _programmed >= _fill) return W25Q64_OK;
+    unsigned int sector = (_oldest + _used - 1) % _sector_count;
+    W25Q64_status_t status = _program(_pageAddress(sector, _page) + _programmed, _image + _programmed, _fill - _programmed);
+    if(status != W25Q64_OK) return status;
+    _programmed = _fill;
+    return W25Q64_OK;
+}
+
+void W25Q64_DeltaLog::rewind(W25Q64_Delta_cursor_t* cursor){
+    cursor->position = 0;
+    cursor->page = 0;
+    cursor->offset = 0;
+    cursor->loaded = false;
+    cursor->codec = _codec;
+}
+
+W25Q64_status_t W25Q64_DeltaLog::next(W25Q64_Delta_cursor_t* cursor, byte* record){
+    while(cursor->position < _used){
+        unsigned int sector = (_oldest + cursor->position) % _sector_count;
+        bool newest = cursor->position == _used - 1;
+        if(cursor->page >= W25Q64_DELTA_SECTOR_PAGES || (newest && cursor->page > _page)){
+            if(newest) break;
+            cursor->position ++;
+            cursor->page = 0;
+            cursor->loaded = false;
+            continue;
+        }
+        if(!cursor->loaded){
+            // the page being filled is served from RAM, it may not be programmed yet
+            if(newest && cursor->page == _page){
+                memcpy(cursor->buff, _image, W25Q64_PAGE_SIZE);
+            }
+            else{
+                W25Q64_status_t status = _flash->fastRead(_pageAddress(sector, cursor->page), cursor->buff, W25Q64_PAGE_SIZE);
+                if(status != W25Q64_OK) return status;
+            }
+            cursor->offset = _pageStart(cursor->page);
+            cursor->codec.reset();
+            cursor->loaded = true;
+        }
+        unsigned int n = 0;
+        if(cursor->offset < W25Q64_PAGE_SIZE && cursor->buff[cursor->offset] != W25Q64_DELTA_END){
+            n = cursor->codec.decode(cursor->buff + cursor->offset, W25Q64_PAGE_SIZE - cursor->offset, record);
+        }
+        if(n == 0){
+            // end of the page
+            cursor->page ++;
+            cursor->loaded = false;
+            continue;
+        }
+        cursor->offset += n;
+        return W25Q64_OK;
+    }
+    return W25Q64_NOT_FOUND;
+}
+
+float W25Q64_DeltaLog::compressionRatio(){
+    if(_encoded_bytes == 0) return 0;
+    return (float)_raw_bytes / (float)_encoded_bytes;
+}
+
+W25Q64_status_t W25Q64_DeltaLog::_open(){
+    W25Q64_status_t status = flush();
+    if(status != W25Q64_OK) return status;
+    if(_used >= _sector_count){
+        // ring is full, the oldest sector is reused
+        _oldest = (_oldest + 1) % _sector_count;
+        _used --;
+    }
+    unsigned int sector = (_oldest + _used) % _sector_count;
+    _flash->waitWhileBusy();
+    _flash->writeEnable();
+    status = _flash->sectorErase(_pageAddress(sector, 0));
+    if(status != W25Q64_OK) return status;
+    _flash->waitWhileBusy();
+    uint32_t header[2] = {W25Q64_DELTA_MAGIC, ++ _sequence};
+    status = _program(_pageAddress(sector, 0), (byte*)header, sizeof(header));
+    if(status != W25Q64_OK) return status;
+    _used ++;
+    _page = 0;
+    memset(_image, 0xFF, W25Q64_PAGE_SIZE);
+    memcpy(_image, header, sizeof(header));
+    _fill = W25Q64_DELTA_HEADER_SIZE;
+    _programmed = W25Q64_DELTA_HEADER_SIZE;
+    _codec.reset();
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_DeltaLog::_program(unsigned int addr, byte* buff, unsigned int len){
+    _flash->writeEnable();
+    W25Q64_status_t status = _flash->pageProgram(addr, buff, len);
+    if(status != W25Q64_OK) return status;
+    return _flash->waitWhileBusy();
+}
@@ -0,0 +1,218 @@
+/**
+ * @file W25Q64_Delta.hpp
+ * @author Jeremy Dunne
+ * @brief Delta + varint compressed record log for the W25Q64
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_DELTA_HPP_
+#define _W25Q64_DELTA_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+
+
+// delta settings
+#define W25Q64_DELTA_MAX_FIELDS             16 // max fields per record
+#define W25Q64_DELTA_MAX_RECORD             64 // max bytes per record
+#define W25Q64_DELTA_MAX_SECTORS            256 // max sectors in the log
+#define W25Q64_DELTA_MAGIC                  0x544C4544 // "DELT"
+#define W25Q64_DELTA_HEADER_SIZE            8 // bytes reserved at the start of every sector
+#define W25Q64_DELTA_END                    0xFF // an erased byte where a record would start ends the page
+
+/**
+ * @brief delta + zigzag/varint record codec
+ *
+ * Records are a fixed sequence of little-endian integer fields of 1, 2 or 4 bytes. Each field is encoded as the
+ *  difference to the same field of the previous record, zigzag mapped so small negative steps stay small, and varint
+ *  packed. A mask byte per 7 fields flags the fields that changed, unchanged fields take no space at all. The top bit of
+ *  a mask byte is always clear so an encoded record never starts with an erased byte.
+ *
+ */
+class W25Q64_DeltaCodec{
+public:
+    /**
+     * @brief set the record layout
+     *
+     * @param field_sizes width in bytes of every field, 1, 2 or 4
+     * @param field_count number of fields, at most W25Q64_DELTA_MAX_FIELDS
+     * @return W25Q64_status_t W25Q64_INVALID_ARGUMENT for an unsupported layout
+     */
+    W25Q64_status_t init(const byte* field_sizes, unsigned int field_count);
+
+    /**
+     * @brief forget the previous record, the next record is encoded against zero
+     *
+     */
+    void reset();
+
+    /**
+     * @brief encode a record against the previous one
+     *
+     * @param record record of recordSize() bytes
+     * @param out buffer of at least maxEncodedSize() bytes
+     * @return unsigned int encoded length
+     */
+    unsigned int encode(const byte* record, byte* out);
+
+    /**
+     * @brief decode a record against the previous one
+     *
+     * @param in encoded data
+     * @param len bytes available
+     * @param record buffer of recordSize() bytes
+     * @return unsigned int bytes consumed, 0 if the data is truncated or corrupt
+     */
+    unsigned int decode(const byte* in, unsigned int len, byte* record);
+
+    /**
+     * @brief get the size of a record
+     *
+     * @return unsigned int record size in bytes
+     */
+    unsigned int recordSize(){return _record_size;};
+
+    /**
+     * @brief get the worst case encoded size of a record
+     *
+     * @return unsigned int max encoded size in bytes
+     */
+    unsigned int maxEncodedSize();
+
+private:
+    byte _field_sizes[W25Q64_DELTA_MAX_FIELDS]; ///< width of every field
+    unsigned int _field_count; ///< fields per record
+    unsigned int _record_size; ///< bytes per record
+    byte _previous[W25Q64_DELTA_MAX_RECORD]; ///< last record encoded or decoded
+};
+
+/**
+ * @brief position of a read through the log
+ *
+ */
+typedef struct{
+    unsigned int position;          ///< sectors from the oldest
+    unsigned int page;              ///< page within the sector
+    unsigned int offset;            ///< byte offset within the page
+    bool loaded;                    ///< true if buff holds the current page
+    byte buff[W25Q64_PAGE_SIZE];    ///< current page
+    W25Q64_DeltaCodec codec;        ///< decoder state for the current page
+} W25Q64_Delta_cursor_t;
+
+/**
+ * @brief append-only log of delta compressed records
+ *
+ * Encoded records are packed into pages in RAM and programmed a page at a time. The codec is reset at every page
+ *  boundary so each page decodes on its own. Sectors form a ring, the oldest is erased once the ring is full.
+ *
+ */
+class W25Q64_DeltaLog{
+public:
+    /**
+     * @brief initialize the log and recover its contents
+     *
+     * @param flash initialized flash chip
+     * @param first_sector first sector of the log
+     * @param sector_count number of sectors, at most W25Q64_DELTA_MAX_SECTORS
+     * @param field_sizes width in bytes of every record field, 1, 2 or 4
+     * @param field_count number of fields
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t init(W25Q64* flash, unsigned int first_sector, unsigned int sector_count, const byte* field_sizes, unsigned int field_count);
+
+    /**
+     * @brief erase the log
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t clear();
+
+    /**
+     * @brief append a record
+     *
+     * @param record record of the configured layout
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t append(const byte* record);
+
+    /**
+     * @brief program the records staged in RAM
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t flush();
+
+    /**
+     * @brief start reading from the oldest record
+     *
+     * @param cursor cursor to set up
+     */
+    void rewind(W25Q64_Delta_cursor_t* cursor);
+
+    /**
+     * @brief read the next record
+     *
+     * @param cursor cursor set up by rewind
+     * @param record buffer for one record
+     * @return W25Q64_status_t W25Q64_NOT_FOUND once all records have been read
+     */
+    W25Q64_status_t next(W25Q64_Delta_cursor_t* cursor, byte* record);
+
+    /**
+     * @brief get the compression ratio of the appended records
+     *
+     * @return float raw bytes over encoded bytes, 0 before the first append
+     */
+    float compressionRatio();
+
+private:
+    W25Q64* _flash; ///< underlying chip
+    W25Q64_DeltaCodec _codec; ///< encoder state for the page being filled
+    unsigned int _first_sector; ///< first sector of the log
+    unsigned int _sector_count; ///< sectors in the ring
+    unsigned int _oldest; ///< ring index of the oldest sector
+    unsigned int _used; ///< sectors holding records
+    uint32_t _sequence; ///< sequence of the newest sector
+    unsigned int _page; ///< page being filled in the newest sector
+    unsigned int _fill; ///< bytes of the page image in use
+    unsigned int _programmed; ///< bytes of the page image already on the chip
+    byte _image[W25Q64_PAGE_SIZE]; ///< page being filled
+    unsigned long _raw_bytes; ///< record bytes appended
+    unsigned long _encoded_bytes; ///< encoded bytes appended
+
+    /**
+     * @brief get the chip address of a page in a ring sector
+     *
+     */
+    unsigned int _pageAddress(unsigned int sector, unsigned int page){
+        return (_first_sector + sector) * W25Q64_SECTOR_SIZE + page * W25Q64_PAGE_SIZE;
+    };
+
+    /**
+     * @brief get the offset of the first record in a page
+     *
+     */
+    unsigned int _pageStart(unsigned int page){
+        return page == 0 ? W25Q64_DELTA_HEADER_SIZE : 0;
+    };
+
+    /**
+     * @brief open the next sector, dropping the oldest if the ring is full
+     *
+     */
+    W25Q64_status_t _open();
+
+    /**
+     * @brief program up to a page and wait for it
+     *
+     */
+    W25Q64_status_t _program(unsigned int addr, byte* buff, unsigned int len);
+};
+
+#endif
@@ -0,0 +1,140 @@
+/**
+ * @file W25Q64_ECC.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 software ECC
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_ECC.hpp"
+
+#define W25Q64_ECC_WORDS                    (W25Q64_PAGE_SIZE / 4)
+#define W25Q64_ECC_CODE_MASK                ((1UL << (2 * W25Q64_ECC_INDEX_BITS)) - 1)
+
+static inline uint32_t _eccParity(uint32_t w){
+    w ^= w >> 16;
+    w ^= w >> 8;
+    w ^= w >> 4;
+    return (0x6996 >> (w & 0xF)) & 1;
+}
+
+static uint32_t _eccCode(const byte* page){
+    uint32_t all = 0; // XOR of every word, bit b set if an odd number of set bits sit at bit b of a word
+    uint32_t high = 0; // XOR of the index of every word with odd parity
+    for(unsigned int i = 0; i < W25Q64_ECC_WORDS; i ++){
+        const byte* p = page + 4 * i;
+        uint32_t w = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+        all ^= w;
+        if(_eccParity(w)) high ^= i;
+    }
+    uint32_t low = 0;
+    for(unsigned int b = 0; b < 32; b ++){
+        if(all & (1UL << b)) low ^= b;
+    }
+    uint32_t p = (high << 5) | low;
+    // P' is the XOR of the complemented indexes, which only differs from P when the page has odd parity
+    uint32_t q = _eccParity(all) ? p ^ W25Q64_ECC_INDEX_MASK : p;
+    return p | (q << W25Q64_ECC_INDEX_BITS);
+}
+
+uint32_t W25Q64_eccCompute(const byte* page){
+    return ~_eccCode(page);
+}
+
+W25Q64_status_t W25Q64_eccCorrect(byte* page, uint32_t code, bool* corrected){
+    *corrected = false;
+    uint32_t syndrome = (_eccCode(page) ^ ~code) & W25Q64_ECC_CODE_MASK;
+    if(syndrome == 0) return W25Q64_OK;
+    uint32_t p = syndrome & W25Q64_ECC_INDEX_MASK;
+    uint32_t q = syndrome >> W25Q64_ECC_INDEX_BITS;
+    if((p ^ q) == W25Q64_ECC_INDEX_MASK){
+        // single data bit, p is its index: word p / 32, bit p % 32 of the little-endian word
+        page[(p >> 5) * 4 + ((p & 31) >> 3)] ^= 1 << (p & 7);
+        *corrected = true;
+        return W25Q64_OK;
+    }
+    if((syndrome & (syndrome - 1)) == 0){
+        // single bit of the code itself, the data is fine
+        *corrected = true;
+        return W25Q64_OK;
+    }
+    return W25Q64_CORRUPT;
+}
+
+W25Q64_status_t W25Q64_ECC::init(W25Q64* flash, unsigned int first_sector, unsigned int sector_count){
+    if(sector_count == 0 || first_sector + sector_count > W25Q64_SECTOR_COUNT) return W25Q64_INVALID_ADDRESS;
+    _flash = flash;
+    _first_sector = first_sector;
+    _sector_count = sector_count;
+    _corrected = 0;
+    _uncorrectable = 0;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_ECC::read(unsigned int addr, byte* buff, unsigned int len){
+    if(addr + len > capacity()) return W25Q64_INVALID_ADDRESS;
+    W25Q64_status_t result = W25Q64_OK;
+    unsigned int code_sector = _sector_count;
+    _flash->waitWhileBusy();
+    while(len > 0){
+        unsigned int page = addr / W25Q64_PAGE_SIZE;
+        unsigned int offset = addr % W25Q64_PAGE_SIZE;
+        unsigned int n = W25Q64_PAGE_SIZE - offset;
+        if(n > len) n = len;
+        // the codes of a sector are fetched once for all the pages read from it
+        if(page / W25Q64_ECC_DATA_PAGES != code_sector){
+            code_sector = page / W25Q64_ECC_DATA_PAGES;
+            W25Q64_status_t status = _flash->fastRead(_codeAddress(code_sector * W25Q64_ECC_DATA_PAGES), (byte*)_codes, sizeof(_codes));
+            if(status != W25Q64_OK) return status;
+        }
+        // whole pages are checked in the caller's buffer, partial ones go through _page
+        byte* target = n == W25Q64_PAGE_SIZE ? buff : _page;
+        W25Q64_status_t status = _flash->fastRead(_pageAddress(page), target, W25Q64_PAGE_SIZE);
+        if(status != W25Q64_OK) return status;
+        bool fixed;
+        if(W25Q64_eccCorrect(target, _codes[page % W25Q64_ECC_DATA_PAGES], &fixed) != W25Q64_OK){
+            _uncorrectable ++;
+            result = W25Q64_CORRUPT;
+        }
+        else if(fixed){
+            _corrected ++;
+        }
+        if(target == _page) memcpy(buff, _page + offset, n);
+        addr += n;
+        buff += n;
+        len -= n;
+    }
+    return result;
+}
+
+W25Q64_status_t W25Q64_ECC::programPage(unsigned int page, byte* buff){
+    if(page >= _sector_count * W25Q64_ECC_DATA_PAGES) return W25Q64_INVALID_ADDRESS;
+    uint32_t code = W25Q64_eccCompute(buff);
+    _flash->waitWhileBusy();
+    W25Q64_status_t status = _program(_pageAddress(page), buff, W25Q64_PAGE_SIZE);
+    if(status != W25Q64_OK) return status;
+    return _program(_codeAddress(page), (byte*)&code, sizeof(code));
+}
+
+W25Q64_status_t W25Q64_ECC::eraseSector(unsigned int sector){
+    W25Q64_status_t status = startErase(sector);
+    if(status != W25Q64_OK) return status;
+    return _flash->waitWhileBusy();
+}
+
+W25Q64_status_t W25Q64_ECC::startErase(unsigned int sector){
+    if(sector >= _sector_count) return W25Q64_INVALID_ADDRESS;
+    _flash->waitWhileBusy();
+    _flash->writeEnable();
+    return _flash->sectorErase((_first_sector + sector) * W25Q64_SECTOR_SIZE);
+}
+
+W25Q64_status_t W25Q64_ECC::_program(unsigned int addr, byte* buff, unsigned int len){
+    _flash->writeEnable();
+    W25Q64_status_t status = _flash->pageProgram(addr, buff, len);
+    if(status != W25Q64_OK) return status;
+    return _flash->waitWhileBusy();
+}
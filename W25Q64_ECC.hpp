@@ -0,0 +1,169 @@
+/**
+ * @file W25Q64_ECC.hpp
+ * @author Jeremy Dunne
+ * @brief Software Hamming ECC per page for the W25Q64
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_ECC_HPP_
+#define _W25Q64_ECC_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+
+
+// ecc settings
+#define W25Q64_ECC_DATA_PAGES               ((W25Q64_SECTOR_SIZE / W25Q64_PAGE_SIZE) - 1) // the last page of every sector holds the parity
+#define W25Q64_ECC_CODE_SIZE                sizeof(uint32_t) // parity bytes per data page
+#define W25Q64_ECC_INDEX_BITS               11 // bits to address any bit of a page
+#define W25Q64_ECC_INDEX_MASK               ((1UL << W25Q64_ECC_INDEX_BITS) - 1)
+
+/**
+ * @brief compute the parity of a page
+ *
+ * The code holds the XOR of the index of every set bit (P) and the XOR of the complement of those indexes (P'), 22 bits.
+ *  It is computed a 32-bit word at a time: the XOR of all words gives the low index bits, the parity of each word the
+ *  high ones. The code is stored inverted so an erased page has an erased code.
+ *
+ * @param page W25Q64_PAGE_SIZE bytes
+ * @return uint32_t code to store
+ */
+uint32_t W25Q64_eccCompute(const byte* page);
+
+/**
+ * @brief check a page against its code and repair a single flipped bit
+ *
+ * A single bit error in the data sets exactly one of each pair of P/P' syndrome bits and is corrected, a single bit
+ *  error in the code itself sets one syndrome bit and is ignored, anything else (two or more bit errors) is reported.
+ *
+ * @param page W25Q64_PAGE_SIZE bytes, corrected in place
+ * @param code stored code
+ * @param corrected set true if a bit was repaired in the data or the code
+ * @return W25Q64_status_t W25Q64_CORRUPT if the page can not be corrected
+ */
+W25Q64_status_t W25Q64_eccCorrect(byte* page, uint32_t code, bool* corrected);
+
+/**
+ * @brief page store protected by software ECC
+ *
+ * Exposes the first W25Q64_ECC_DATA_PAGES pages of every sector in a range as a linear address space and keeps their
+ *  codes in the last page of the sector. Pages are programmed whole so the code covers what is on the chip; reads
+ *  check every page they touch, correct single bit errors and count them so scrubbing can be scheduled.
+ *
+ */
+class W25Q64_ECC{
+public:
+    /**
+     * @brief initialize the store
+     *
+     * @param flash initialized flash chip
+     * @param first_sector first sector of the store
+     * @param sector_count number of sectors
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t init(W25Q64* flash, unsigned int first_sector, unsigned int sector_count);
+
+    /**
+     * @brief read and correct data
+     *
+     * @param addr address in the store
+     * @param buff buffer to read into
+     * @param len number of bytes
+     * @return W25Q64_status_t W25Q64_CORRUPT if a page had more errors than can be corrected, the rest is still read
+     */
+    W25Q64_status_t read(unsigned int addr, byte* buff, unsigned int len);
+
+    /**
+     * @brief program a whole page and its code, the page must be erased
+     *
+     * @param page page number in the store
+     * @param buff W25Q64_PAGE_SIZE bytes
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t programPage(unsigned int page, byte* buff);
+
+    /**
+     * @brief erase a sector of the store, data and codes
+     *
+     * @param sector sector number in the store
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t eraseSector(unsigned int sector);
+
+    /**
+     * @brief start erasing a sector of the store without waiting for it
+     *
+     * The next read or program waits for the erase to finish
+     *
+     * @param sector sector number in the store
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t startErase(unsigned int sector);
+
+    /**
+     * @brief get the size of the store
+     *
+     * @return unsigned int usable bytes
+     */
+    unsigned int capacity(){return _sector_count * W25Q64_ECC_DATA_PAGES * W25Q64_PAGE_SIZE;};
+
+    /**
+     * @brief get the number of sectors in the store
+     *
+     * @return unsigned int sector count
+     */
+    unsigned int sectorCount(){return _sector_count;};
+
+    /**
+     * @brief get the number of bit errors corrected since init
+     *
+     * @return unsigned long corrected errors
+     */
+    unsigned long corrected(){return _corrected;};
+
+    /**
+     * @brief get the number of page reads that could not be corrected since init
+     *
+     * @return unsigned long uncorrectable pages
+     */
+    unsigned long uncorrectable(){return _uncorrectable;};
+
+private:
+    W25Q64* _flash; ///< underlying chip
+    unsigned int _first_sector; ///< first sector of the store
+    unsigned int _sector_count; ///< sectors in the store
+    unsigned long _corrected; ///< bit errors corrected
+    unsigned long _uncorrectable; ///< pages that failed to correct
+    byte _page[W25Q64_PAGE_SIZE]; ///< page buffer for partial reads
+    uint32_t _codes[W25Q64_ECC_DATA_PAGES]; ///< codes of the sector being read
+
+    /**
+     * @brief get the chip address of a page in the store
+     *
+     */
+    unsigned int _pageAddress(unsigned int page){
+        return (_first_sector + page / W25Q64_ECC_DATA_PAGES) * W25Q64_SECTOR_SIZE + (page % W25Q64_ECC_DATA_PAGES) * W25Q64_PAGE_SIZE;
+    };
+
+    /**
+     * @brief get the chip address of the code of a page
+     *
+     */
+    unsigned int _codeAddress(unsigned int page){
+        return (_first_sector + page / W25Q64_ECC_DATA_PAGES) * W25Q64_SECTOR_SIZE + W25Q64_ECC_DATA_PAGES * W25Q64_PAGE_SIZE + (page % W25Q64_ECC_DATA_PAGES) * W25Q64_ECC_CODE_SIZE;
+    };
+
+    /**
+     * @brief program up to a page and wait for it
+     *
+     */
+    W25Q64_status_t _program(unsigned int addr, byte* buff, unsigned int len);
+};
+
+#endif
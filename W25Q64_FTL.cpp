@@ -0,0 +1,329 @@
+/**
+ * @file W25Q64_FTL.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 flash translation layer
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_FTL.hpp"
+
+W25Q64_status_t W25Q64_FTL::init(W25Q64* flash, unsigned int first_sector, unsigned int sector_count){
+    // check the range
+    if(sector_count > W25Q64_FTL_MAX_SECTORS || sector_count <= W25Q64_FTL_RESERVED_SECTORS) return W25Q64_INVALID_ADDRESS;
+    if(first_sector + sector_count > W25Q64_SECTOR_COUNT) return W25Q64_INVALID_ADDRESS;
+    _flash = flash;
+    _first_sector = first_sector;
+    _sector_count = sector_count;
+    _block_count = (sector_count - W25Q64_FTL_RESERVED_SECTORS) * W25Q64_FTL_SLOTS_PER_SECTOR;
+    _sequence = 0;
+    _active[0] = _active[1] = sector_count;
+    _active_slot[0] = _active_slot[1] = 0;
+    _host_bytes = 0;
+    _flash_bytes = 0;
+    _erases = 0;
+    _migrations = 0;
+    _cold_victim = sector_count;
+    for(unsigned int i = 0; i < _block_count; i ++){
+        _map[i] = W25Q64_FTL_UNMAPPED;
+    }
+    _gc.init(flash, this, first_sector, sector_count, W25Q64_FTL_SLOTS_PER_SECTOR * W25Q64_FTL_BLOCK_SIZE);
+    _flash->waitWhileBusy();
+
+    // replay the tag journal of every sector
+    uint32_t active_sequence = 0;
+    W25Q64_FTL_header_t header;
+    W25Q64_FTL_tag_t tags[W25Q64_FTL_SLOTS_PER_SECTOR];
+    for(unsigned int sector = 0; sector < _sector_count; sector ++){
+        _flash->fastRead(_sectorAddress(sector), (byte*)&header, sizeof(header));
+        if(header.magic != W25Q64_FTL_MAGIC){
+            // unformatted or interrupted erase, erase on first use
+            _state[sector] = W25Q64_FTL_SECTOR_DIRTY;
+            _erase_count[sector] = 0;
+            continue;
+        }
+        _erase_count[sector] = header.erase_count;
+        _flash->fastRead(_sectorAddress(sector) + W25Q64_FTL_TAG_OFFSET, (byte*)tags, sizeof(tags));
+        unsigned int used = 0;
+        for(unsigned int i = 0; i < W25Q64_FTL_SLOTS_PER_SECTOR; i ++){
+            W25Q64_FTL_tag_t* tag = &tags[i];
+            uint16_t slot = sector * 8 + i + 1;
+            bool blank = tag->block == 0xFFFF && tag->state == W25Q64_FTL_TAG_FREE && tag->reserved == 0xFF && tag->sequence == 0xFFFFFFFF;
+            if(blank) continue;
+            used = i + 1;
+            if(tag->state != W25Q64_FTL_TAG_VALID || tag->block >= _block_count) continue;
+            if(tag->sequence >= _sequence) _sequence = tag->sequence + 1;
+            uint16_t current = _map[tag->block];
+            if(current != W25Q64_FTL_UNMAPPED){
+                // two copies survived a power loss, keep the newer one
+                W25Q64_FTL_tag_t other;
+                _flash->fastRead(_tagAddress(current), (byte*)&other, sizeof(other));
+                byte obsolete = W25Q64_FTL_TAG_OBSOLETE;
+                if(other.sequence > tag->sequence){
+                    _program(_tagAddress(slot) + 2, &obsolete, 1);
+                    continue;
+                }
+                _program(_tagAddress(current) + 2, &obsolete, 1);
+                _gc.removeValid(current / 8, W25Q64_FTL_BLOCK_SIZE);
+            }
+            _map[tag->block] = slot;
+            _gc.addValid(sector, W25Q64_FTL_BLOCK_SIZE);
+        }
+        if(used == 0){
+            _state[sector] = W25Q64_FTL_SECTOR_FREE;
+        }
+        else{
+            _state[sector] = W25Q64_FTL_SECTOR_USED;
+            // resume filling the most recently written sector
+            if(used < W25Q64_FTL_SLOTS_PER_SECTOR){
+                uint32_t newest = 0;
+                for(unsigned int i = 0; i < used; i ++){
+                    if(tags[i].sequence != 0xFFFFFFFF && tags[i].sequence >= newest) newest = tags[i].sequence + 1;
+                }
+                if(newest > active_sequence){
+                    if(_active[0] < _sector_count) _state[_active[0]] = W25Q64_FTL_SECTOR_USED;
+                    active_sequence = newest;
+                    _active[0] = sector;
+                    _active_slot[0] = used;
+                    _state[sector] = W25Q64_FTL_SECTOR_ACTIVE;
+                }
+            }
+        }
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_FTL::format(){
+    // a collection or migration in progress refers to data that is about to go away
+    W25Q64_status_t status = _gc.reset();
+    if(status != W25Q64_OK) return status;
+    _cold_victim = _sector_count;
+    for(unsigned int sector = 0; sector < _sector_count; sector ++){
+        status = _erase(sector);
+        if(status != W25Q64_OK) return status;
+    }
+    for(unsigned int i = 0; i < _block_count; i ++){
+        _map[i] = W25Q64_FTL_UNMAPPED;
+    }
+    _active[0] = _active[1] = _sector_count;
+    _active_slot[0] = _active_slot[1] = 0;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_FTL::readBlocks(unsigned int block, byte* buff, unsigned int count){
+    if(block + count > _block_count) return W25Q64_INVALID_ADDRESS;
+    while(count > 0){
+        uint16_t slot = _map[block];
+        if(slot == W25Q64_FTL_UNMAPPED){
+            memset(buff, 0xFF, W25Q64_FTL_BLOCK_SIZE);
+        }
+        else{
+            W25Q64_status_t status = _gc.read(_slotAddress(slot), buff, W25Q64_FTL_BLOCK_SIZE);
+            if(status != W25Q64_OK) return status;
+        }
+        buff += W25Q64_FTL_BLOCK_SIZE;
+        block ++;
+        count --;
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_FTL::writeBlocks(unsigned int block, byte* buff, unsigned int count){
+    if(block + count > _block_count) return W25Q64_INVALID_ADDRESS;
+    while(count > 0){
+        W25Q64_status_t status = _writeBlock(block, buff, false);
+        if(status != W25Q64_OK) return status;
+        _host_bytes += W25Q64_FTL_BLOCK_SIZE;
+        buff += W25Q64_FTL_BLOCK_SIZE;
+        block ++;
+        count --;
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_FTL::sync(){
+    W25Q64_status_t status = _gc.finish();
+    if(status != W25Q64_OK) return status;
+    return _flash->waitWhileBusy();
+}
+
+W25Q64_status_t W25Q64_FTL::gcStep(){
+    if(_gc.state() != W25Q64_GC_IDLE) return _gc.step();
+    unsigned int free = freeSectors();
+    if(free <= 1) return _gc.step();
+    // look for cold data sitting on a low-wear sector, a migration needs a spare sector beyond the reserve
+    int cold = -1;
+    uint32_t hottest = 0;
+    for(unsigned int sector = 0; sector < _sector_count; sector ++){
+        if(_erase_count[sector] > hottest) hottest = _erase_count[sector];
+        if(_state[sector] != W25Q64_FTL_SECTOR_USED) continue;
+        if(cold < 0 || _erase_count[sector] < _erase_count[cold]) cold = sector;
+    }
+    if(cold < 0 || hottest - _erase_count[cold] <= W25Q64_FTL_WEAR_THRESHOLD){
+        if(free <= W25Q64_FTL_GC_THRESHOLD) return _gc.step();
+        return W25Q64_OK;
+    }
+    W25Q64_status_t status = _gc.start(cold);
+    if(status != W25Q64_OK) return status;
+    _cold_victim = cold;
+    _migrations ++;
+    return W25Q64_OK;
+}
+
+unsigned long W25Q64_FTL::wearSpread(){
+    uint32_t least = 0xFFFFFFFF, most = 0;
+    for(unsigned int sector = 0; sector < _sector_count; sector ++){
+        if(_erase_count[sector] < least) least = _erase_count[sector];
+        if(_erase_count[sector] > most) most = _erase_count[sector];
+    }
+    return most - least;
+}
+
+unsigned int W25Q64_FTL::freeSectors(){
+    unsigned int count = 0;
+    for(unsigned int sector = 0; sector < _sector_count; sector ++){
+        if(_state[sector] == W25Q64_FTL_SECTOR_FREE || _state[sector] == W25Q64_FTL_SECTOR_DIRTY) count ++;
+    }
+    return count;
+}
+
+bool W25Q64_FTL::gcCandidate(unsigned int sector){
+    return _state[sector] == W25Q64_FTL_SECTOR_USED;
+}
+
+W25Q64_status_t W25Q64_FTL::gcRelocate(unsigned int sector, unsigned int* offset){
+    W25Q64_FTL_tag_t tags[W25Q64_FTL_SLOTS_PER_SECTOR];
+    _gc.read(_sectorAddress(sector) + W25Q64_FTL_TAG_OFFSET, (byte*)tags, sizeof(tags));
+    unsigned int i = *offset / W25Q64_FTL_BLOCK_SIZE;
+    if(i > 0) i --;
+    for(; i < W25Q64_FTL_SLOTS_PER_SECTOR; i ++){
+        uint16_t slot = sector * 8 + i + 1;
+        if(tags[i].block >= _block_count || _map[tags[i].block] != slot) continue;
+        // copy the live block forward, the old slot stays mapped until the copy is in place
+        W25Q64_status_t status = _gc.read(_slotAddress(slot), _buffer, W25Q64_FTL_BLOCK_SIZE);
+        if(status == W25Q64_OK) status = _writeBlock(tags[i].block, _buffer, true);
+        if(status != W25Q64_OK){
+            if(sector == _cold_victim) _cold_victim = _sector_count;
+            return status;
+        }
+        *offset = (i + 2) * W25Q64_FTL_BLOCK_SIZE;
+        return W25Q64_OK;
+    }
+    *offset = W25Q64_SECTOR_SIZE;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_FTL::gcErased(unsigned int sector){
+    if(sector == _cold_victim) _cold_victim = _sector_count;
+    _erases ++;
+    _erase_count[sector] ++;
+    return _format(sector);
+}
+
+float W25Q64_FTL::writeAmplification(){
+    if(_host_bytes == 0) return 0;
+    return (float)_flash_bytes / (float)_host_bytes;
+}
+
+W25Q64_status_t W25Q64_FTL::_program(unsigned int addr, byte* buff, unsigned int len){
+    _flash->writeEnable();
+    W25Q64_status_t status = _gc.program(addr, buff, len);
+    if(status != W25Q64_OK) return status;
+    _flash_bytes += len;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_FTL::_erase(unsigned int sector){
+    _flash->waitWhileBusy();
+    _flash->writeEnable();
+    W25Q64_status_t status = _flash->sectorErase(_sectorAddress(sector));
+    if(status != W25Q64_OK) return status;
+    _flash->waitWhileBusy();
+    _erases ++;
+    _erase_count[sector] ++;
+    return _format(sector);
+}
+
+W25Q64_status_t W25Q64_FTL::_format(unsigned int sector){
+    // stamp the header so the erase count survives a reboot
+    W25Q64_FTL_header_t header;
+    memset(&header, 0xFF, sizeof(header));
+    header.magic = W25Q64_FTL_MAGIC;
+    header.erase_count = _erase_count[sector];
+    W25Q64_status_t status = _program(_sectorAddress(sector), (byte*)&header, sizeof(header));
+    if(status != W25Q64_OK) return status;
+    _state[sector] = W25Q64_FTL_SECTOR_FREE;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_FTL::_writeBlock(unsigned int block, byte* buff, bool relocating){
+    W25Q64_status_t status = _allocate(relocating);
+    if(status != W25Q64_OK) return status;
+    unsigned int stream = relocating ? 1 : 0;
+    unsigned int sector = _active[stream];
+    uint16_t slot = sector * 8 + _active_slot[stream] + 1;
+    _active_slot[stream] ++;
+
+    // journal the slot before the data so an interrupted write is never mistaken for a free slot
+    W25Q64_FTL_tag_t tag;
+    tag.block = block;
+    tag.state = W25Q64_FTL_TAG_ALLOCATED;
+    tag.reserved = 0xFF;
+    tag.sequence = _sequence ++;
+    status = _program(_tagAddress(slot), (byte*)&tag, sizeof(tag));
+    if(status != W25Q64_OK) return status;
+    for(unsigned int offset = 0; offset < W25Q64_FTL_BLOCK_SIZE; offset += W25Q64_PAGE_SIZE){
+        status = _program(_slotAddress(slot) + offset, buff + offset, W25Q64_PAGE_SIZE);
+        if(status != W25Q64_OK) return status;
+    }
+    byte state = W25Q64_FTL_TAG_VALID;
+    status = _program(_tagAddress(slot) + 2, &state, 1);
+    if(status != W25Q64_OK) return status;
+
+    // retire the previous copy, a relocated one sits on the victim which is erased afterwards so it is not marked obsolete
+    uint16_t previous = _map[block];
+    if(previous != W25Q64_FTL_UNMAPPED){
+        state = W25Q64_FTL_TAG_OBSOLETE;
+        if(!relocating) _program(_tagAddress(previous) + 2, &state, 1);
+        _gc.removeValid(previous / 8, W25Q64_FTL_BLOCK_SIZE);
+    }
+    _map[block] = slot;
+    _gc.addValid(sector, W25Q64_FTL_BLOCK_SIZE);
+    if(_active_slot[stream] >= W25Q64_FTL_SLOTS_PER_SECTOR){
+        _state[sector] = W25Q64_FTL_SECTOR_USED;
+        _active[stream] = _sector_count;
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_FTL::_allocate(bool relocating){
+    unsigned int stream = relocating ? 1 : 0;
+    if(_active[stream] < _sector_count) return W25Q64_OK;
+    // keep one free sector back so collection always has somewhere to relocate to
+    while(!relocating && freeSectors() <= 1){
+        W25Q64_status_t status = _gc.collect();
+        if(status != W25Q64_OK) return status;
+    }
+    // dynamic wear leveling, take the least worn free sector. Cold data being migrated goes to the most worn one instead
+    bool coldest = relocating && _cold_victim < _sector_count;
+    int best = -1;
+    for(unsigned int sector = 0; sector < _sector_count; sector ++){
+        bool free = _state[sector] == W25Q64_FTL_SECTOR_FREE || _state[sector] == W25Q64_FTL_SECTOR_DIRTY;
+        if(!free) continue;
+        if(best < 0) best = sector;
+        else if(!coldest && _erase_count[sector] < _erase_count[best]) best = sector;
+        else if(coldest && _erase_count[sector] > _erase_count[best]) best = sector;
+    }
+    if(best < 0) return W25Q64_FULL;
+    if(_state[best] == W25Q64_FTL_SECTOR_DIRTY){
+        W25Q64_status_t status = _erase(best);
+        if(status != W25Q64_OK) return status;
+    }
+    _active[stream] = best;
+    _active_slot[stream] = 0;
+    _state[best] = W25Q64_FTL_SECTOR_ACTIVE;
+    return W25Q64_OK;
+}
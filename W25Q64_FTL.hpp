@@ -0,0 +1,292 @@
+/**
+ * @file W25Q64_FTL.hpp
+ * @author Jeremy Dunne
+ * @brief Flash translation layer exposing the W25Q64 as a 512-byte block device
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_FTL_HPP_
+#define _W25Q64_FTL_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+#include "W25Q64_GC.hpp"
+
+
+// FTL settings
+#define W25Q64_FTL_BLOCK_SIZE               512 // bytes per logical block
+#define W25Q64_FTL_SLOTS_PER_SECTOR         7 // data slots per sector, slot 0 holds the sector header
+#define W25Q64_FTL_MAX_SECTORS              W25Q64_GC_MAX_SECTORS // max sectors managed, sizes the RAM tables
+#define W25Q64_FTL_RESERVED_SECTORS         4 // sectors kept back from the logical capacity for garbage collection
+#define W25Q64_FTL_GC_THRESHOLD             2 // background collection starts at or below this many free sectors
+#define W25Q64_FTL_WEAR_THRESHOLD           128 // erase count spread that triggers static wear leveling
+#define W25Q64_FTL_UNMAPPED                 0xFFFF
+
+// on-flash layout
+#define W25Q64_FTL_MAGIC                    0x4C544657 // "WFTL"
+#define W25Q64_FTL_TAG_OFFSET               16 // offset of the tag table in the sector header
+
+// tag states, each transition only clears bits
+#define W25Q64_FTL_TAG_FREE                 0xFF
+#define W25Q64_FTL_TAG_ALLOCATED            0xFE // tag written, data not yet complete
+#define W25Q64_FTL_TAG_VALID                0xFC // data complete
+#define W25Q64_FTL_TAG_OBSOLETE             0x00 // superseded by a newer copy
+
+/**
+ * @brief header written to the start of every formatted sector
+ *
+ */
+typedef struct{
+    uint32_t magic;         ///< W25Q64_FTL_MAGIC once formatted
+    uint32_t erase_count;   ///< number of times this sector has been erased
+    uint32_t reserved[2];   ///< left erased
+} W25Q64_FTL_header_t;
+
+/**
+ * @brief journal entry describing the contents of one data slot
+ *
+ */
+typedef struct{
+    uint16_t block;         ///< logical block stored in the slot
+    uint8_t state;          ///< W25Q64_FTL_TAG_* state
+    uint8_t reserved;       ///< left erased
+    uint32_t sequence;      ///< write sequence, newest copy wins at mount
+} W25Q64_FTL_tag_t;
+
+// sector states, kept in RAM only
+typedef enum{
+    W25Q64_FTL_SECTOR_DIRTY = 0,    ///< needs an erase before use
+    W25Q64_FTL_SECTOR_FREE,         ///< formatted with no slots used
+    W25Q64_FTL_SECTOR_ACTIVE,       ///< currently being filled
+    W25Q64_FTL_SECTOR_USED          ///< holds data, candidate for collection
+} W25Q64_FTL_sector_state_t;
+
+/**
+ * @brief page-mapped flash translation layer
+ *
+ * Exposes a range of sectors as an array of 512-byte logical blocks. Every write goes out-of-place into the next free slot,
+ *  the old copy is marked obsolete in place, and sectors are reclaimed by garbage collection. Each sector header carries a
+ *  tag per slot which forms the persisted mapping journal; the logical to physical map is rebuilt from it on init. Free
+ *  sectors are handed out lowest erase count first. Collection is driven by W25Q64_GC, so victim erases overlap with
+ *  foreground reads and writes.
+ *
+ */
+class W25Q64_FTL : public W25Q64_GCClient{
+public:
+    /**
+     * @brief mount the translation layer
+     *
+     * Scans the tag journal of every sector in the range and rebuilds the mapping. Sectors without a valid header are
+     *  formatted lazily when first needed.
+     *
+     * @param flash initialized flash chip
+     * @param first_sector index of the first sector to manage
+     * @param sector_count number of sectors to manage, at most W25Q64_FTL_MAX_SECTORS
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t init(W25Q64* flash, unsigned int first_sector, unsigned int sector_count);
+
+    /**
+     * @brief erase every sector in the range and drop all mappings
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t format();
+
+    /**
+     * @brief read logical blocks
+     *
+     * Unwritten blocks read back as 0xFF
+     *
+     * @param block first logical block
+     * @param buff buffer of count * W25Q64_FTL_BLOCK_SIZE bytes
+     * @param count number of blocks to read
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t readBlocks(unsigned int block, byte* buff, unsigned int count);
+
+    /**
+     * @brief write logical blocks
+     *
+     * Runs garbage collection in the foreground if the free sector reserve is exhausted
+     *
+     * @param block first logical block
+     * @param buff buffer of count * W25Q64_FTL_BLOCK_SIZE bytes
+     * @param count number of blocks to write
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t writeBlocks(unsigned int block, byte* buff, unsigned int count);
+
+    /**
+     * @brief wait for any outstanding flash operation
+     *
+     * Writes are durable once they return, this only makes sure the chip is idle
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t sync();
+
+    /**
+     * @brief perform background garbage collection
+     *
+     * Performs one bounded collection step, relocating at most one block or polling the victim erase. A new collection
+     *  only starts once the number of free sectors is at or below W25Q64_FTL_GC_THRESHOLD. If the erase count spread
+     *  exceeds W25Q64_FTL_WEAR_THRESHOLD, the least worn sector holding data is migrated onto the most worn free sector
+     *  first, so cold data stops pinning low-wear sectors (static wear leveling). Call from an idle loop to keep both out
+     *  of the write path.
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t gcStep();
+
+    /**
+     * @brief get the number of logical blocks
+     *
+     * @return unsigned int logical block count
+     */
+    unsigned int blockCount(){return _block_count;};
+
+    /**
+     * @brief get the number of free sectors
+     *
+     * @return unsigned int sectors formatted or waiting for an erase
+     */
+    unsigned int freeSectors();
+
+    /**
+     * @brief get the write amplification
+     *
+     * Bytes programmed to the chip (data, relocations and journal) over bytes written by the host
+     *
+     * @return float write amplification, 0 before the first write
+     */
+    float writeAmplification();
+
+    /**
+     * @brief get the bytes written through writeBlocks
+     *
+     * @return unsigned long host bytes
+     */
+    unsigned long hostBytesWritten(){return _host_bytes;};
+
+    /**
+     * @brief get the bytes programmed to the chip
+     *
+     * @return unsigned long flash bytes
+     */
+    unsigned long flashBytesWritten(){return _flash_bytes;};
+
+    /**
+     * @brief get the number of sector erases performed
+     *
+     * @return unsigned long erase count
+     */
+    unsigned long erases(){return _erases;};
+
+    /**
+     * @brief get the difference between the most and least worn sectors
+     *
+     * @return unsigned long erase count spread
+     */
+    unsigned long wearSpread();
+
+    /**
+     * @brief get the number of static wear leveling migrations started
+     *
+     * @return unsigned long migration count
+     */
+    unsigned long wearMigrations(){return _migrations;};
+
+    // garbage collector hooks, see W25Q64_GCClient \\ 
+
+    bool gcCandidate(unsigned int sector);
+    W25Q64_status_t gcRelocate(unsigned int sector, unsigned int* offset);
+    W25Q64_status_t gcErased(unsigned int sector);
+
+protected:
+    W25Q64* _flash; ///< underlying chip
+    W25Q64_GC _gc; ///< garbage collector over the managed range
+    unsigned int _first_sector; ///< first sector in the managed range
+    unsigned int _sector_count; ///< sectors in the managed range
+    unsigned int _block_count; ///< exposed logical blocks
+    uint32_t _sequence; ///< next write sequence
+    unsigned int _active[2]; ///< sectors currently being filled by the host and by relocation
+    unsigned int _active_slot[2]; ///< next slot in each active sector
+    uint16_t _map[W25Q64_FTL_MAX_SECTORS * W25Q64_FTL_SLOTS_PER_SECTOR]; ///< logical block to physical slot
+    uint8_t _state[W25Q64_FTL_MAX_SECTORS]; ///< W25Q64_FTL_sector_state_t per sector
+    uint32_t _erase_count[W25Q64_FTL_MAX_SECTORS]; ///< erase count per sector
+    byte _buffer[W25Q64_FTL_BLOCK_SIZE]; ///< relocation buffer
+    unsigned long _host_bytes;
+    unsigned long _flash_bytes;
+    unsigned long _erases;
+    unsigned long _migrations;
+    unsigned int _cold_victim; ///< sector being migrated by static wear leveling, _sector_count if none
+
+    /**
+     * @brief get the chip address of a sector in the range
+     *
+     */
+    unsigned int _sectorAddress(unsigned int sector){
+        return (_first_sector + sector) * W25Q64_SECTOR_SIZE;
+    };
+
+    /**
+     * @brief get the chip address of a physical slot
+     *
+     */
+    unsigned int _slotAddress(uint16_t slot){
+        return _sectorAddress(slot / 8) + (slot % 8) * W25Q64_FTL_BLOCK_SIZE;
+    };
+
+    /**
+     * @brief get the chip address of the tag for a physical slot
+     *
+     */
+    unsigned int _tagAddress(uint16_t slot){
+        return _sectorAddress(slot / 8) + W25Q64_FTL_TAG_OFFSET + ((slot % 8) - 1) * sizeof(W25Q64_FTL_tag_t);
+    };
+
+    /**
+     * @brief program up to a page and wait for completion
+     *
+     */
+    W25Q64_status_t _program(unsigned int addr, byte* buff, unsigned int len);
+
+    /**
+     * @brief erase a sector in the range and write its header
+     *
+     */
+    W25Q64_status_t _erase(unsigned int sector);
+
+    /**
+     * @brief write one block out-of-place and update the mapping
+     *
+     * @param relocating true when called from garbage collection
+     */
+    W25Q64_status_t _writeBlock(unsigned int block, byte* buff, bool relocating);
+
+    /**
+     * @brief make sure the active sector has a free slot
+     *
+     * Relocated blocks are kept in their own active sector, separating cold data from host writes and making sure host
+     *  writes never eat into the sector held back for collection.
+     *
+     * @param relocating true when called from garbage collection, which may use the last free sector. While a static wear
+     *  leveling migration is running relocation takes the most worn free sector instead of the least worn.
+     */
+    W25Q64_status_t _allocate(bool relocating);
+
+    /**
+     * @brief write the header of a freshly erased sector
+     *
+     */
+    W25Q64_status_t _format(unsigned int sector);
+};
+
+#endif
@@ -0,0 +1,65 @@
+/**
+ * @file W25Q64_Find.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 pattern search
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_Find.hpp"
+
+// search shared by find and findAll, stops after max_hits matches
+static W25Q64_status_t _findSearch(W25Q64* flash, unsigned int addr, unsigned int len, const byte* pattern, unsigned int pattern_len, unsigned int* hits, unsigned int max_hits, unsigned int* count){
+    *count = 0;
+    if(pattern_len == 0 || pattern_len > W25Q64_FIND_MAX_PATTERN || max_hits == 0) return W25Q64_INVALID_ARGUMENT;
+    if(addr + len > W25Q64_MAX_ADDRESS + 1) return W25Q64_INVALID_ADDRESS;
+    // Horspool shift: distance from the last occurrence of a byte (last pattern byte excluded) to the pattern end
+    byte shift[256];
+    memset(shift, pattern_len, sizeof(shift));
+    for(unsigned int i = 0; i + 1 < pattern_len; i ++){
+        shift[pattern[i]] = pattern_len - 1 - i;
+    }
+    byte last = pattern[pattern_len - 1];
+    byte buff[W25Q64_FIND_WINDOW + W25Q64_FIND_MAX_PATTERN - 1];
+    unsigned int kept = 0; // bytes carried over from the previous window
+    unsigned int base = addr; // chip address of buff[0]
+    unsigned int i = 0; // next alignment to check, relative to buff
+    flash->waitWhileBusy();
+    while(len > 0){
+        unsigned int n = len < W25Q64_FIND_WINDOW ? len : W25Q64_FIND_WINDOW;
+        W25Q64_status_t status = flash->fastRead(base + kept, &buff[kept], n);
+        if(status != W25Q64_OK) return status;
+        len -= n;
+        unsigned int have = kept + n;
+        while(i + pattern_len <= have){
+            byte end = buff[i + pattern_len - 1];
+            if(end == last && memcmp(&buff[i], pattern, pattern_len - 1) == 0){
+                hits[*count] = base + i;
+                (*count) ++;
+                if(*count == max_hits) return len > 0 || i + 1 + pattern_len <= have ? W25Q64_FULL : W25Q64_OK;
+            }
+            i += shift[end];
+        }
+        // keep the tail a match could still start in
+        kept = have < pattern_len - 1 ? have : pattern_len - 1;
+        memmove(buff, &buff[have - kept], kept);
+        base += have - kept;
+        i -= have - kept;
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_find(W25Q64* flash, unsigned int addr, unsigned int len, const byte* pattern, unsigned int pattern_len, unsigned int* match){
+    unsigned int count;
+    W25Q64_status_t status = _findSearch(flash, addr, len, pattern, pattern_len, match, 1, &count);
+    if(status == W25Q64_FULL) return W25Q64_OK;
+    if(status != W25Q64_OK) return status;
+    return count > 0 ? W25Q64_OK : W25Q64_NOT_FOUND;
+}
+
+W25Q64_status_t W25Q64_findAll(W25Q64* flash, unsigned int addr, unsigned int len, const byte* pattern, unsigned int pattern_len, unsigned int* hits, unsigned int max_hits, unsigned int* count){
+    return _findSearch(flash, addr, len, pattern, pattern_len, hits, max_hits, count);
+}
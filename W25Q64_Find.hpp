@@ -0,0 +1,57 @@
+/**
+ * @file W25Q64_Find.hpp
+ * @author Jeremy Dunne
+ * @brief Pattern search over W25Q64 memory
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_FIND_HPP_
+#define _W25Q64_FIND_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+
+
+// search settings
+#define W25Q64_FIND_WINDOW                  256 // bytes read from the chip at a time
+#define W25Q64_FIND_MAX_PATTERN             64 // longest pattern searched for
+
+/**
+ * @brief find the first occurrence of a pattern in a range of the chip
+ *
+ * The range is streamed through a small window on the stack and searched with Boyer-Moore-Horspool, which skips ahead by
+ *  up to the pattern length on a mismatch. The last pattern length - 1 bytes of a window are carried into the next one,
+ *  so matches across window boundaries are found.
+ *
+ * @param flash initialized flash chip
+ * @param addr start of the range
+ * @param len length of the range
+ * @param pattern bytes to look for
+ * @param pattern_len length of the pattern, 1 to W25Q64_FIND_MAX_PATTERN
+ * @param match address of the first match
+ * @return W25Q64_status_t W25Q64_NOT_FOUND if the pattern is not in the range
+ */
+W25Q64_status_t W25Q64_find(W25Q64* flash, unsigned int addr, unsigned int len, const byte* pattern, unsigned int pattern_len, unsigned int* match);
+
+/**
+ * @brief find every occurrence of a pattern in a range of the chip, overlapping ones included
+ *
+ * @param flash initialized flash chip
+ * @param addr start of the range
+ * @param len length of the range
+ * @param pattern bytes to look for
+ * @param pattern_len length of the pattern, 1 to W25Q64_FIND_MAX_PATTERN
+ * @param hits array the match addresses are written to, in order
+ * @param max_hits size of hits, the search stops once it is full
+ * @param count number of matches written to hits
+ * @return W25Q64_status_t W25Q64_FULL if hits filled up before the end of the range
+ */
+W25Q64_status_t W25Q64_findAll(W25Q64* flash, unsigned int addr, unsigned int len, const byte* pattern, unsigned int pattern_len, unsigned int* hits, unsigned int max_hits, unsigned int* count);
+
+#endif
@@ -0,0 +1,163 @@
+/**
+ * @file W25Q64_GC.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 incremental garbage collector
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_GC.hpp"
+
+W25Q64_status_t W25Q64_GC::init(W25Q64* flash, W25Q64_GCClient* client, unsigned int first_sector, unsigned int sector_count, unsigned int capacity){
+    if(sector_count > W25Q64_GC_MAX_SECTORS) return W25Q64_INVALID_ADDRESS;
+    _flash = flash;
+    _client = client;
+    _first_sector = first_sector;
+    _sector_count = sector_count;
+    _capacity = capacity;
+    _resumed_at = 0;
+    _suspends = 0;
+    _state = W25Q64_GC_IDLE;
+    return reset();
+}
+
+void W25Q64_GC::addValid(unsigned int sector, unsigned int bytes){
+    _valid[sector] += bytes;
+    _modified[sector] = ++ _clock;
+}
+
+void W25Q64_GC::removeValid(unsigned int sector, unsigned int bytes){
+    if(bytes > _valid[sector]) bytes = _valid[sector];
+    _valid[sector] -= bytes;
+}
+
+int W25Q64_GC::selectVictim(){
+    // cost-benefit: age * free / (read + rewrite of the live data)
+    int victim = -1;
+    float best = 0;
+    for(unsigned int sector = 0; sector < _sector_count; sector ++){
+        if(_valid[sector] >= _capacity) continue;
+        if(!_client->gcCandidate(sector)) continue;
+        float age = (float)(_clock - _modified[sector]) + 1;
+        float score = age * (float)(_capacity - _valid[sector]) / (float)(_capacity + _valid[sector]);
+        if(victim < 0 || score > best){
+            victim = sector;
+            best = score;
+        }
+    }
+    return victim;
+}
+
+W25Q64_status_t W25Q64_GC::start(unsigned int sector){
+    if(_state != W25Q64_GC_IDLE) return W25Q64_BUSY;
+    if(sector >= _sector_count) return W25Q64_INVALID_ADDRESS;
+    _victim = sector;
+    _offset = 0;
+    _state = W25Q64_GC_COPYING;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_GC::step(){
+    W25Q64_status_t status;
+    switch(_state){
+        case W25Q64_GC_IDLE: {
+            int victim = selectVictim();
+            if(victim < 0) return W25Q64_OK;
+            _victim = victim;
+            _offset = 0;
+            _state = W25Q64_GC_COPYING;
+            return W25Q64_OK;
+        }
+        case W25Q64_GC_COPYING:
+            if(_offset < W25Q64_SECTOR_SIZE){
+                status = _client->gcRelocate(_victim, &_offset);
+                // a failed relocation leaves live data on the victim, it must not be erased
+                if(status != W25Q64_OK) _state = W25Q64_GC_IDLE;
+                return status;
+            }
+            // everything live has moved, start the erase and leave it running
+            _flash->waitWhileBusy();
+            _flash->writeEnable();
+            status = _flash->sectorErase((_first_sector + _victim) * W25Q64_SECTOR_SIZE);
+            if(status != W25Q64_OK) return status;
+            _state = W25Q64_GC_ERASING;
+            return W25Q64_OK;
+        case W25Q64_GC_ERASING:
+            if(_flash->busy()) return W25Q64_OK;
+            _state = W25Q64_GC_IDLE;
+            _valid[_victim] = 0;
+            _modified[_victim] = _clock;
+            return _client->gcErased(_victim);
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_GC::collect(){
+    if(_state == W25Q64_GC_IDLE){
+        if(selectVictim() < 0) return W25Q64_FULL;
+        step();
+    }
+    while(_state != W25Q64_GC_IDLE){
+        W25Q64_status_t status = step();
+        if(status != W25Q64_OK) return status;
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_GC::finish(){
+    while(_state == W25Q64_GC_ERASING){
+        W25Q64_status_t status = step();
+        if(status != W25Q64_OK) return status;
+        yield();
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_GC::reset(){
+    W25Q64_status_t status = finish();
+    if(status != W25Q64_OK) return status;
+    _state = W25Q64_GC_IDLE;
+    _clock = 0;
+    for(unsigned int i = 0; i < _sector_count; i ++){
+        _valid[i] = 0;
+        _modified[i] = 0;
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_GC::read(unsigned int addr, byte* buff, unsigned int len){
+    bool suspended = _suspend();
+    W25Q64_status_t status = _flash->fastRead(addr, buff, len);
+    if(suspended) _resume();
+    return status;
+}
+
+W25Q64_status_t W25Q64_GC::program(unsigned int addr, byte* buff, unsigned int len){
+    bool suspended = _suspend();
+    _flash->writeEnable();
+    W25Q64_status_t status = _flash->pageProgram(addr, buff, len);
+    if(status == W25Q64_OK) status = _flash->waitWhileBusy();
+    if(suspended) _resume();
+    return status;
+}
+
+bool W25Q64_GC::_suspend(){
+    if(_state != W25Q64_GC_ERASING || !_flash->busy()) return false;
+    // give the erase some time to progress since the last resume
+    while(micros() - _resumed_at < W25Q64_GC_RESUME_INTERVAL_US){
+        yield();
+    }
+    _flash->eraseProgramSuspend();
+    // busy clears once the chip has entered the suspended state
+    _flash->waitWhileBusy();
+    _suspends ++;
+    return true;
+}
+
+void W25Q64_GC::_resume(){
+    _flash->eraseProgramResume();
+    _resumed_at = micros();
+}
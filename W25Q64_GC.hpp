@@ -0,0 +1,231 @@
+/**
+ * @file W25Q64_GC.hpp
+ * @author Jeremy Dunne
+ * @brief Incremental garbage collector for log-structured layers on the W25Q64
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_GC_HPP_
+#define _W25Q64_GC_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+
+
+// GC settings
+#define W25Q64_GC_MAX_SECTORS               256 // max sectors tracked, sizes the RAM tables
+#define W25Q64_GC_RESUME_INTERVAL_US        100 // minimum time an erase runs between two suspends so it keeps making progress
+
+// collector states
+typedef enum{
+    W25Q64_GC_IDLE = 0,     ///< no collection in progress
+    W25Q64_GC_COPYING,      ///< relocating live data out of the victim
+    W25Q64_GC_ERASING       ///< victim erase issued, waiting on the chip
+} W25Q64_GC_state_t;
+
+/**
+ * @brief interface implemented by a layer that owns the data being collected
+ *
+ */
+class W25Q64_GCClient{
+public:
+    /**
+     * @brief check if a sector may be collected
+     *
+     * @param sector sector index within the collected range
+     * @return bool true if the sector holds data and is not being written to
+     */
+    virtual bool gcCandidate(unsigned int sector) = 0;
+
+    /**
+     * @brief relocate the next live unit of a victim sector
+     *
+     * Moves at most one unit (record, block, page) of live data found at or after offset, then advances offset past it.
+     *  Sets offset to W25Q64_SECTOR_SIZE once the sector holds no more live data. An error abandons the collection, the
+     *  victim is not erased.
+     *
+     * @param sector victim sector index
+     * @param offset byte offset within the sector to resume from
+     * @return W25Q64_status_t standard return type
+     */
+    virtual W25Q64_status_t gcRelocate(unsigned int sector, unsigned int* offset) = 0;
+
+    /**
+     * @brief called once the victim erase has completed
+     *
+     * @param sector erased sector index
+     * @return W25Q64_status_t standard return type
+     */
+    virtual W25Q64_status_t gcErased(unsigned int sector) = 0;
+};
+
+/**
+ * @brief cost-benefit garbage collector
+ *
+ * Tracks the valid bytes and age of every sector in a range and picks the victim with the best age * free / cost ratio.
+ *  Collection runs in bounded steps, a single relocation or a single status poll, so it can be driven from an idle hook.
+ *  The victim erase is left running on the chip; reads and programs issued through the collector while it runs are
+ *  served by suspending the erase.
+ *
+ */
+class W25Q64_GC{
+public:
+    /**
+     * @brief initialize the collector
+     *
+     * @param flash initialized flash chip
+     * @param client layer owning the collected data
+     * @param first_sector index of the first sector in the range
+     * @param sector_count number of sectors, at most W25Q64_GC_MAX_SECTORS
+     * @param capacity payload bytes a sector can hold
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t init(W25Q64* flash, W25Q64_GCClient* client, unsigned int first_sector, unsigned int sector_count, unsigned int capacity);
+
+    /**
+     * @brief record live bytes written to a sector
+     *
+     * @param sector sector index
+     * @param bytes live bytes added
+     */
+    void addValid(unsigned int sector, unsigned int bytes);
+
+    /**
+     * @brief record live bytes in a sector becoming stale
+     *
+     * @param sector sector index
+     * @param bytes live bytes removed
+     */
+    void removeValid(unsigned int sector, unsigned int bytes);
+
+    /**
+     * @brief get the live bytes in a sector
+     *
+     * @param sector sector index
+     * @return unsigned int valid bytes
+     */
+    unsigned int validBytes(unsigned int sector){return _valid[sector];};
+
+    /**
+     * @brief pick the best victim by cost-benefit
+     *
+     * @return int sector index, -1 if no candidate has anything to reclaim
+     */
+    int selectVictim();
+
+    /**
+     * @brief start collecting a specific sector
+     *
+     * Used to move data off a sector regardless of its cost-benefit score, the work is done by following steps
+     *
+     * @param sector sector index
+     * @return W25Q64_status_t W25Q64_BUSY if a collection is already in progress
+     */
+    W25Q64_status_t start(unsigned int sector);
+
+    /**
+     * @brief perform one bounded unit of collection work
+     *
+     * Starts a new collection when idle and a victim exists
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t step();
+
+    /**
+     * @brief run steps until a full collection has completed
+     *
+     * Finishes the collection in progress, or runs a new one when idle
+     *
+     * @return W25Q64_status_t W25Q64_FULL if there was nothing to collect
+     */
+    W25Q64_status_t collect();
+
+    /**
+     * @brief block until a pending victim erase has completed
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t finish();
+
+    /**
+     * @brief drop the collection in progress and forget all valid byte counts, used after the range is reformatted
+     *
+     * Waits for a pending victim erase first, a victim still being copied is abandoned without being erased
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t reset();
+
+    /**
+     * @brief get the collector state
+     *
+     * @return W25Q64_GC_state_t current state
+     */
+    W25Q64_GC_state_t state(){return _state;};
+
+    /**
+     * @brief fast read that suspends a running victim erase
+     *
+     * @param addr 24-bit address to read from
+     * @param buff byte buffer to read into
+     * @param len number of bytes to read
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t read(unsigned int addr, byte* buff, unsigned int len);
+
+    /**
+     * @brief program up to a page and wait for it, suspending a running victim erase
+     *
+     * Issues the write enable itself. Must not target the sector being erased.
+     *
+     * @param addr 24-bit address to write to
+     * @param buff byte buffer to write
+     * @param len length to write
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t program(unsigned int addr, byte* buff, unsigned int len);
+
+    /**
+     * @brief get the number of erase suspends issued
+     *
+     * @return unsigned long suspend count
+     */
+    unsigned long suspends(){return _suspends;};
+
+private:
+    W25Q64* _flash; ///< underlying chip
+    W25Q64_GCClient* _client; ///< owner of the collected data
+    unsigned int _first_sector; ///< first sector in the range
+    unsigned int _sector_count; ///< sectors in the range
+    unsigned int _capacity; ///< payload bytes per sector
+    W25Q64_GC_state_t _state; ///< collector state
+    unsigned int _victim; ///< sector being collected
+    unsigned int _offset; ///< relocation cursor within the victim
+    uint32_t _clock; ///< logical time, advanced on every write
+    uint16_t _valid[W25Q64_GC_MAX_SECTORS]; ///< live bytes per sector
+    uint32_t _modified[W25Q64_GC_MAX_SECTORS]; ///< time of the youngest data per sector
+    unsigned long _resumed_at; ///< micros() of the last resume
+    unsigned long _suspends;
+
+    /**
+     * @brief suspend the victim erase if it is still running
+     *
+     * @return bool true if the erase was suspended and must be resumed
+     */
+    bool _suspend();
+
+    /**
+     * @brief resume the suspended victim erase
+     *
+     */
+    void _resume();
+};
+
+#endif
@@ -0,0 +1,278 @@
+/**
+ * @file W25Q64_LZ.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 streaming LZ compressed blobs
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_LZ.hpp"
+
+#define W25Q64_LZ_HASH_SIZE                 (1 << W25Q64_LZ_HASH_BITS)
+#define W25Q64_LZ_NO_MATCH                  0xFFFF
+
+// block codec \\
+
+static unsigned int _lzHash(const byte* p){
+    uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+    return (uint32_t)(v * 2654435761UL) >> (32 - W25Q64_LZ_HASH_BITS);
+}
+
+static bool _lzLiterals(const byte* in, unsigned int count, byte* out, unsigned int* n, unsigned int limit){
+    while(count > 0){
+        unsigned int run = count > W25Q64_LZ_MAX_LITERALS ? W25Q64_LZ_MAX_LITERALS : count;
+        if(*n + 1 + run >= limit) return false;
+        out[(*n) ++] = (byte)(run - 1);
+        memcpy(out + *n, in, run);
+        *n += run;
+        in += run;
+        count -= run;
+    }
+    return true;
+}
+
+unsigned int W25Q64_lzCompress(const byte* in, unsigned int len, byte* out, unsigned int limit){
+    uint16_t table[W25Q64_LZ_HASH_SIZE];
+    for(unsigned int i = 0; i < W25Q64_LZ_HASH_SIZE; i ++) table[i] = W25Q64_LZ_NO_MATCH;
+    unsigned int n = 0;
+    unsigned int literal = 0;
+    unsigned int i = 0;
+    while(i + W25Q64_LZ_MIN_MATCH <= len){
+        unsigned int hash = _lzHash(in + i);
+        unsigned int candidate = table[hash];
+        table[hash] = i;
+        if(candidate == W25Q64_LZ_NO_MATCH || memcmp(in + candidate, in + i, W25Q64_LZ_MIN_MATCH) != 0){
+            i ++;
+            continue;
+        }
+        unsigned int match = W25Q64_LZ_MIN_MATCH;
+        while(i + match < len && match < W25Q64_LZ_MAX_MATCH && in[candidate + match] == in[i + match]) match ++;
+        if(!_lzLiterals(in + literal, i - literal, out, &n, limit)) return 0;
+        if(n + 3 >= limit) return 0;
+        unsigned int distance = i - candidate;
+        out[n ++] = 0x80 | (byte)(match - W25Q64_LZ_MIN_MATCH);
+        out[n ++] = (byte)distance;
+        out[n ++] = (byte)(distance >> 8);
+        // index the positions inside the match so later data can refer back into it
+        for(unsigned int k = 1; k < match && i + k + W25Q64_LZ_MIN_MATCH <= len; k ++){
+            table[_lzHash(in + i + k)] = i + k;
+        }
+        i += match;
+        literal = i;
+    }
+    if(!_lzLiterals(in + literal, len - literal, out, &n, limit)) return 0;
+    return n;
+}
+
+bool W25Q64_lzDecompress(const byte* in, unsigned int len, byte* out, unsigned int raw_length){
+    unsigned int i = 0;
+    unsigned int n = 0;
+    while(i < len){
+        byte token = in[i ++];
+        if(token & 0x80){
+            if(i + 2 > len) return false;
+            unsigned int match = (token & 0x7F) + W25Q64_LZ_MIN_MATCH;
+            unsigned int distance = in[i] | ((unsigned int)in[i + 1] << 8);
+            i += 2;
+            if(distance == 0 || distance > n || n + match > raw_length) return false;
+            // byte by byte, a match may overlap the bytes it produces
+            for(unsigned int k = 0; k < match; k ++, n ++) out[n] = out[n - distance];
+        }
+        else{
+            unsigned int run = token + 1;
+            if(i + run > len || n + run > raw_length) return false;
+            memcpy(out + n, in + i, run);
+            i += run;
+            n += run;
+        }
+    }
+    return n == raw_length;
+}
+
+// writer \\
+
+W25Q64_status_t W25Q64_LZWriter::begin(W25Q64* flash, unsigned int addr, unsigned int capacity){
+    // sectors are erased whole as the blob enters them, so the region must be whole sectors
+    if(addr % W25Q64_SECTOR_SIZE != 0 || capacity < W25Q64_SECTOR_SIZE || capacity % W25Q64_SECTOR_SIZE != 0) return W25Q64_INVALID_ADDRESS;
+    if(addr + capacity > W25Q64_MAX_ADDRESS + 1) return W25Q64_INVALID_ADDRESS;
+    _flash = flash;
+    _addr = addr;
+    _capacity = capacity;
+    _raw_size = 0;
+    _stored_size = 0;
+    _block_fill = 0;
+    // the header is left erased until finish()
+    memset(_page, 0xFF, W25Q64_PAGE_SIZE);
+    _page_fill = W25Q64_LZ_HEADER_SIZE;
+    return _erase(_addr);
+}
+
+W25Q64_status_t W25Q64_LZWriter::write(const byte* buff, unsigned int len){
+    while(len > 0){
+        unsigned int n = W25Q64_LZ_BLOCK_SIZE - _block_fill;
+        if(n > len) n = len;
+        memcpy(_block + _block_fill, buff, n);
+        _block_fill += n;
+        if(_block_fill == W25Q64_LZ_BLOCK_SIZE){
+            W25Q64_status_t status = _storeBlock();
+            if(status != W25Q64_OK){
+                // the rejected bytes are not part of the blob, the ones written before them are still stored by finish()
+                _block_fill -= n;
+                return status;
+            }
+        }
+        buff += n;
+        len -= n;
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_LZWriter::finish(){
+    W25Q64_status_t status;
+    if(_block_fill > 0){
+        status = _storeBlock();
+        if(status != W25Q64_OK) return status;
+    }
+    if(_page_fill > 0){
+        status = _programPage();
+        if(status != W25Q64_OK) return status;
+    }
+    W25Q64_LZ_header_t header = {W25Q64_LZ_MAGIC, _raw_size, _stored_size, W25Q64_LZ_BLOCK_SIZE};
+    _flash->writeEnable();
+    status = _flash->pageProgram(_addr, (byte*)&header, sizeof(header));
+    if(status != W25Q64_OK) return status;
+    return _flash->waitWhileBusy();
+}
+
+W25Q64_status_t W25Q64_LZWriter::_storeBlock(){
+    W25Q64_LZ_block_t block;
+    block.raw_length = _block_fill;
+    // compressed only if strictly smaller than raw
+    block.stored_length = W25Q64_lzCompress(_block, _block_fill, _compressed, _block_fill);
+    const byte* data = _compressed;
+    if(block.stored_length == 0){
+        block.stored_length = _block_fill;
+        data = _block;
+    }
+    if(W25Q64_LZ_HEADER_SIZE + _stored_size + sizeof(block) + block.stored_length > _capacity) return W25Q64_FULL;
+    _raw_size += _block_fill;
+    _block_fill = 0;
+    W25Q64_status_t status = _emit((const byte*)&block, sizeof(block));
+    if(status != W25Q64_OK) return status;
+    return _emit(data, block.stored_length);
+}
+
+W25Q64_status_t W25Q64_LZWriter::_emit(const byte* buff, unsigned int len){
+    while(len > 0){
+        unsigned int addr = _addr + W25Q64_LZ_HEADER_SIZE + _stored_size;
+        if(addr % W25Q64_SECTOR_SIZE == 0){
+            W25Q64_status_t status = _erase(addr);
+            if(status != W25Q64_OK) return status;
+        }
+        unsigned int n = W25Q64_PAGE_SIZE - _page_fill;
+        if(n > len) n = len;
+        memcpy(_page + _page_fill, buff, n);
+        _page_fill += n;
+        _stored_size += n;
+        buff += n;
+        len -= n;
+        if(_page_fill == W25Q64_PAGE_SIZE){
+            W25Q64_status_t status = _programPage();
+            if(status != W25Q64_OK) return status;
+        }
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_LZWriter::_programPage(){
+    // erased bytes in front of the staged data program nothing
+    unsigned int addr = (_addr + W25Q64_LZ_HEADER_SIZE + _stored_size - 1) / W25Q64_PAGE_SIZE * W25Q64_PAGE_SIZE;
+    _flash->writeEnable();
+    W25Q64_status_t status = _flash->pageProgram(addr, _page, _page_fill);
+    if(status != W25Q64_OK) return status;
+    status = _flash->waitWhileBusy();
+    memset(_page, 0xFF, W25Q64_PAGE_SIZE);
+    _page_fill = 0;
+    return status;
+}
+
+W25Q64_status_t W25Q64_LZWriter::_erase(unsigned int addr){
+    _flash->waitWhileBusy();
+    _flash->writeEnable();
+    W25Q64_status_t status = _flash->sectorErase(addr);
+    if(status != W25Q64_OK) return status;
+    return _flash->waitWhileBusy();
+}
+
+// reader \\
+
+W25Q64_status_t W25Q64_LZReader::open(W25Q64* flash, unsigned int addr){
+    _flash = flash;
+    _addr = addr;
+    _flash->waitWhileBusy();
+    W25Q64_status_t status = _flash->fastRead(_addr, (byte*)&_header, sizeof(_header));
+    if(status != W25Q64_OK) return status;
+    if(_header.magic != W25Q64_LZ_MAGIC || _header.block_size != W25Q64_LZ_BLOCK_SIZE){
+        _header.raw_size = 0;
+        rewind();
+        return W25Q64_NOT_FOUND;
+    }
+    rewind();
+    return W25Q64_OK;
+}
+
+void W25Q64_LZReader::rewind(){
+    _position = 0;
+    _next = _addr + W25Q64_LZ_HEADER_SIZE;
+    _current.raw_length = 0;
+    _current.stored_length = 0;
+    _offset = 0;
+}
+
+W25Q64_status_t W25Q64_LZReader::read(byte* buff, unsigned int len, unsigned int* count){
+    *count = 0;
+    while(len > 0 && _position < _header.raw_size){
+        if(_offset >= _current.raw_length){
+            W25Q64_status_t status = _loadBlock();
+            if(status != W25Q64_OK) return status;
+        }
+        unsigned int n = _current.raw_length - _offset;
+        if(n > len) n = len;
+        if(_current.stored_length == _current.raw_length){
+            W25Q64_status_t status = _flash->fastRead(_current_addr + _offset, buff, n);
+            if(status != W25Q64_OK) return status;
+        }
+        else{
+            memcpy(buff, _block + _offset, n);
+        }
+        _offset += n;
+        _position += n;
+        *count += n;
+        buff += n;
+        len -= n;
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_LZReader::_loadBlock(){
+    W25Q64_status_t status = _flash->fastRead(_next, (byte*)&_current, sizeof(_current));
+    if(status != W25Q64_OK) return status;
+    if(_current.raw_length == 0 || _current.raw_length > W25Q64_LZ_BLOCK_SIZE || _current.stored_length > _current.raw_length){
+        _current.raw_length = 0;
+        return W25Q64_CORRUPT;
+    }
+    _current_addr = _next + sizeof(_current);
+    _next = _current_addr + _current.stored_length;
+    _offset = 0;
+    if(_current.stored_length == _current.raw_length) return W25Q64_OK;
+    status = _flash->fastRead(_current_addr, _compressed, _current.stored_length);
+    if(status != W25Q64_OK) return status;
+    if(!W25Q64_lzDecompress(_compressed, _current.stored_length, _block, _current.raw_length)){
+        _current.raw_length = 0;
+        return W25Q64_CORRUPT;
+    }
+    return W25Q64_OK;
+}
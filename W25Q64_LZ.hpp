@@ -0,0 +1,231 @@
+/**
+ * @file W25Q64_LZ.hpp
+ * @author Jeremy Dunne
+ * @brief Streaming LZ compressed blobs on the W25Q64
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_LZ_HPP_
+#define _W25Q64_LZ_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+
+
+// lz settings
+#define W25Q64_LZ_BLOCK_SIZE                512 // raw bytes per block, also the match window, at most 65535
+#define W25Q64_LZ_HASH_BITS                 8 // match finder hash table of 2^bits entries
+#define W25Q64_LZ_MIN_MATCH                 3
+#define W25Q64_LZ_MAX_MATCH                 (0x7F + W25Q64_LZ_MIN_MATCH)
+#define W25Q64_LZ_MAX_LITERALS              0x80
+#define W25Q64_LZ_MAGIC                     0x425A4C57 // "WLZB"
+#define W25Q64_LZ_HEADER_SIZE               16 // bytes reserved at the start of the blob
+
+/**
+ * @brief header at the start of a blob, programmed once the blob is finished
+ *
+ */
+typedef struct{
+    uint32_t magic;             ///< W25Q64_LZ_MAGIC
+    uint32_t raw_size;          ///< uncompressed bytes
+    uint32_t stored_size;       ///< bytes on the chip after the header
+    uint32_t block_size;        ///< W25Q64_LZ_BLOCK_SIZE of the writer
+} W25Q64_LZ_header_t;
+
+/**
+ * @brief header in front of every block
+ *
+ * A block is stored raw if stored_length equals raw_length, compressed otherwise
+ *
+ */
+typedef struct{
+    uint16_t raw_length;        ///< uncompressed bytes in the block
+    uint16_t stored_length;     ///< bytes following the header
+} W25Q64_LZ_block_t;
+
+/**
+ * @brief compress a block
+ *
+ * Greedy LZ77 over the block itself. A token with the top bit clear is followed by token + 1 literals, a token with the
+ *  top bit set copies (token & 0x7F) + W25Q64_LZ_MIN_MATCH bytes from a 16-bit little-endian distance back.
+ *
+ * @param in block to compress, at most W25Q64_LZ_BLOCK_SIZE bytes
+ * @param len bytes in the block
+ * @param out buffer for the compressed block
+ * @param limit size of out, compression gives up once the output would reach it
+ * @return unsigned int compressed length, 0 if it does not beat limit
+ */
+unsigned int W25Q64_lzCompress(const byte* in, unsigned int len, byte* out, unsigned int limit);
+
+/**
+ * @brief decompress a block
+ *
+ * @param in compressed block
+ * @param len compressed length
+ * @param out buffer for the block
+ * @param raw_length uncompressed length of the block
+ * @return bool true if the block decoded to exactly raw_length bytes
+ */
+bool W25Q64_lzDecompress(const byte* in, unsigned int len, byte* out, unsigned int raw_length);
+
+/**
+ * @brief writes a compressed blob as a stream
+ *
+ * Data is gathered into blocks of W25Q64_LZ_BLOCK_SIZE, each block is compressed and kept only if that beats storing it
+ *  raw. Blocks are packed back to back and programmed a page at a time, sectors are erased as the blob grows into them.
+ *  The header is programmed by finish(), a blob cut short by a reset is never opened.
+ *
+ */
+class W25Q64_LZWriter{
+public:
+    /**
+     * @brief start a new blob
+     *
+     * @param flash initialized flash chip
+     * @param addr sector aligned start address
+     * @param capacity bytes reserved for the blob on the chip, a multiple of W25Q64_SECTOR_SIZE
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t begin(W25Q64* flash, unsigned int addr, unsigned int capacity);
+
+    /**
+     * @brief append data to the blob
+     *
+     * @param buff data to append
+     * @return W25Q64_status_t W25Q64_FULL if the blob outgrows its capacity, the block that did not fit is left out
+     * @return W25Q64_status_t W25Q64_FULL if the blob outgrows its capacity
+     */
+    W25Q64_status_t write(const byte* buff, unsigned int len);
+
+    /**
+     * @brief store the last block and program the header
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t finish();
+
+    /**
+     * @brief get the bytes written so far
+     *
+     * @return unsigned int uncompressed size
+     */
+    unsigned int rawSize(){return _raw_size;};
+
+    /**
+     * @brief get the bytes stored so far, block headers included
+     *
+     * @return unsigned int stored size
+     */
+    unsigned int storedSize(){return _stored_size;};
+
+private:
+    W25Q64* _flash; ///< underlying chip
+    unsigned int _addr; ///< start of the blob
+    unsigned int _capacity; ///< bytes reserved for the blob
+    unsigned int _raw_size; ///< bytes written
+    unsigned int _stored_size; ///< bytes stored after the header
+    unsigned int _block_fill; ///< bytes gathered in _block
+    unsigned int _page_fill; ///< bytes staged in _page
+    byte _block[W25Q64_LZ_BLOCK_SIZE]; ///< block being gathered
+    byte _compressed[W25Q64_LZ_BLOCK_SIZE]; ///< compressed block
+    byte _page[W25Q64_PAGE_SIZE]; ///< page being staged
+
+    /**
+     * @brief compress and store the gathered block
+     *
+     */
+    W25Q64_status_t _storeBlock();
+
+    /**
+     * @brief append stored bytes, programming full pages and erasing sectors on entry
+     *
+     */
+    W25Q64_status_t _emit(const byte* buff, unsigned int len);
+
+    /**
+     * @brief program the staged page
+     *
+     */
+    W25Q64_status_t _programPage();
+
+    /**
+     * @brief erase a sector and wait for it
+     *
+     */
+    W25Q64_status_t _erase(unsigned int addr);
+};
+
+/**
+ * @brief reads a compressed blob as a stream
+ *
+ * Blocks are fetched with fastRead() and decompressed one at a time as the read position reaches them. Raw blocks are
+ *  read straight into the caller's buffer.
+ *
+ */
+class W25Q64_LZReader{
+public:
+    /**
+     * @brief open a blob
+     *
+     * @param flash initialized flash chip
+     * @param addr start address the blob was written to
+     * @return W25Q64_status_t W25Q64_NOT_FOUND if there is no finished blob at addr
+     */
+    W25Q64_status_t open(W25Q64* flash, unsigned int addr);
+
+    /**
+     * @brief read the next bytes of the blob
+     *
+     * @param buff buffer to read into
+     * @param len number of bytes wanted
+     * @param count number of bytes read, less than len at the end of the blob
+     * @return W25Q64_status_t W25Q64_CORRUPT if a block fails to decode
+     */
+    W25Q64_status_t read(byte* buff, unsigned int len, unsigned int* count);
+
+    /**
+     * @brief go back to the start of the blob
+     *
+     */
+    void rewind();
+
+    /**
+     * @brief get the uncompressed size of the blob
+     *
+     * @return unsigned int blob size
+     */
+    unsigned int size(){return _header.raw_size;};
+
+    /**
+     * @brief get the bytes left to read
+     *
+     * @return unsigned int remaining bytes
+     */
+    unsigned int remaining(){return _header.raw_size - _position;};
+
+private:
+    W25Q64* _flash; ///< underlying chip
+    unsigned int _addr; ///< start of the blob
+    W25Q64_LZ_header_t _header; ///< blob header
+    unsigned int _position; ///< bytes read
+    unsigned int _next; ///< chip address of the next block header
+    W25Q64_LZ_block_t _current; ///< block being read
+    unsigned int _current_addr; ///< chip address of the current block data
+    unsigned int _offset; ///< bytes read from the current block
+    byte _compressed[W25Q64_LZ_BLOCK_SIZE]; ///< compressed block
+    byte _block[W25Q64_LZ_BLOCK_SIZE]; ///< decompressed block
+
+    /**
+     * @brief fetch the next block header, decompressing the block if needed
+     *
+     */
+    W25Q64_status_t _loadBlock();
+};
+
+#endif
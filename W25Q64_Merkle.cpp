@@ -0,0 +1,257 @@
+/**
+ * @file W25Q64_Merkle.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 incremental hash tree
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_Merkle.hpp"
+
+#define W25Q64_MERKLE_LEAVES_PER_PAGE       (W25Q64_PAGE_SIZE / 4)
+#define W25Q64_MERKLE_BITS_PER_PAGE         (W25Q64_PAGE_SIZE * 8)
+
+// parent of two nodes
+static uint32_t _merkleNode(uint32_t left, uint32_t right){
+    byte buff[8];
+    memcpy(&buff[0], &left, 4);
+    memcpy(&buff[4], &right, 4);
+    return W25Q64_crc32(buff, 8);
+}
+
+// add the next leaf to a tree built bottom up, only one pending node per level is kept
+static void _merklePush(uint32_t* nodes, unsigned int* levels, unsigned int* depth, uint32_t hash){
+    unsigned int level = 0;
+    while(*depth > 0 && levels[*depth - 1] == level){
+        (*depth) --;
+        hash = _merkleNode(nodes[*depth], hash);
+        level ++;
+    }
+    nodes[*depth] = hash;
+    levels[*depth] = level;
+    (*depth) ++;
+}
+
+W25Q64_status_t W25Q64_Merkle::init(W25Q64* flash, unsigned int first_sector, unsigned int count, unsigned int meta_sector){
+    if(count == 0 || count > W25Q64_MERKLE_MAX_SECTORS || first_sector + count > W25Q64_SECTOR_COUNT) return W25Q64_INVALID_ARGUMENT;
+    unsigned int meta_count = metaSectors(count);
+    if(meta_sector + meta_count > W25Q64_SECTOR_COUNT) return W25Q64_INVALID_ADDRESS;
+    if(meta_sector < first_sector + count && first_sector < meta_sector + meta_count) return W25Q64_INVALID_ADDRESS;
+    _flash = flash;
+    _first = first_sector;
+    _count = count;
+    _meta = meta_sector;
+    _half = 0;
+    _loaded = false;
+    _unsynced = false;
+    memset(_dirty, 0, sizeof(_dirty));
+    memset(&_header, 0, sizeof(_header));
+    flash->addObserver(this);
+    // the valid half with the newest commit wins
+    W25Q64_Merkle_header_t header;
+    for(unsigned int half = 0; half < 2; half ++){
+        if(!_loadHalf(half, &header)) continue;
+        if(_loaded && (int32_t)(header.sequence - _header.sequence) <= 0) continue;
+        _header = header;
+        _half = half;
+        _loaded = true;
+    }
+    if(!_loaded) return W25Q64_NOT_FOUND;
+    // a cleared bit in the bitmap marks a dirty sector
+    byte buff[W25Q64_PAGE_SIZE];
+    for(unsigned int page = 0; page < _bitmapPages(); page ++){
+        _flash->waitWhileBusy();
+        W25Q64_status_t status = _flash->fastRead(_halfAddress(_half) + (1 + page) * W25Q64_PAGE_SIZE, buff, W25Q64_PAGE_SIZE);
+        if(status != W25Q64_OK) return status;
+        for(unsigned int i = 0; i < W25Q64_PAGE_SIZE && page * W25Q64_PAGE_SIZE + i < sizeof(_dirty); i ++){
+            _dirty[page * W25Q64_PAGE_SIZE + i] = ~buff[i];
+        }
+    }
+    return W25Q64_OK;
+}
+
+unsigned int W25Q64_Merkle::metaSectors(unsigned int count){
+    unsigned int bitmap_pages = (count + W25Q64_MERKLE_BITS_PER_PAGE - 1) / W25Q64_MERKLE_BITS_PER_PAGE;
+    unsigned int bytes = (1 + bitmap_pages) * W25Q64_PAGE_SIZE + count * 4;
+    return 2 * ((bytes + W25Q64_SECTOR_SIZE - 1) / W25Q64_SECTOR_SIZE);
+}
+
+W25Q64_status_t W25Q64_Merkle::build(){
+    return _commit(true);
+}
+
+W25Q64_status_t W25Q64_Merkle::update(){
+    if(!_loaded) return W25Q64_NOT_FOUND;
+    if(dirty() == 0) return W25Q64_OK;
+    return _commit(false);
+}
+
+W25Q64_status_t W25Q64_Merkle::verify(uint32_t expected){
+    W25Q64_status_t status = update();
+    if(status != W25Q64_OK) return status;
+    return _header.root == expected ? W25Q64_OK : W25Q64_CORRUPT;
+}
+
+W25Q64_status_t W25Q64_Merkle::verifySector(unsigned int sector){
+    if(sector < _first || sector >= _first + _count) return W25Q64_INVALID_ADDRESS;
+    if(!_loaded) return W25Q64_NOT_FOUND;
+    unsigned int index = sector - _first;
+    // a dirty sector is expected to differ until the next update
+    if(_dirty[index / 8] & (1 << (index % 8))) return W25Q64_BUSY;
+    uint32_t leaf;
+    _flash->waitWhileBusy();
+    unsigned int addr = _halfAddress(_half) + (1 + _bitmapPages()) * W25Q64_PAGE_SIZE + index * 4;
+    W25Q64_status_t status = _flash->fastRead(addr, (byte*)&leaf, 4);
+    if(status != W25Q64_OK) return status;
+    uint32_t hash;
+    status = _hashSector(index, &hash);
+    if(status != W25Q64_OK) return status;
+    return hash == leaf ? W25Q64_OK : W25Q64_CORRUPT;
+}
+
+W25Q64_status_t W25Q64_Merkle::sync(){
+    if(!_loaded || !_unsynced) return W25Q64_OK;
+    byte buff[W25Q64_PAGE_SIZE];
+    for(unsigned int page = 0; page < _bitmapPages(); page ++){
+        // programming only clears bits, marks already on flash stay and clean sectors stay erased
+        memset(buff, 0xFF, W25Q64_PAGE_SIZE);
+        for(unsigned int i = 0; i < W25Q64_PAGE_SIZE && page * W25Q64_PAGE_SIZE + i < sizeof(_dirty); i ++){
+            buff[i] = ~_dirty[page * W25Q64_PAGE_SIZE + i];
+        }
+        W25Q64_status_t status = _flash->program(_halfAddress(_half) + (1 + page) * W25Q64_PAGE_SIZE, buff, W25Q64_PAGE_SIZE);
+        if(status != W25Q64_OK) return status;
+    }
+    _unsynced = false;
+    return W25Q64_OK;
+}
+
+void W25Q64_Merkle::mutated(W25Q64_mutation_t, unsigned int addr, const byte*, unsigned int len){
+    if(len == 0) return;
+    unsigned int first = addr / W25Q64_SECTOR_SIZE;
+    unsigned int last = (addr + len - 1) / W25Q64_SECTOR_SIZE;
+    if(first < _first) first = _first;
+    if(last >= _first + _count) last = _first + _count - 1;
+    for(unsigned int sector = first; sector <= last; sector ++){
+        unsigned int index = sector - _first;
+        _dirty[index / 8] |= 1 << (index % 8);
+        _unsynced = true;
+    }
+}
+
+unsigned int W25Q64_Merkle::dirty(){
+    unsigned int count = 0;
+    for(unsigned int index = 0; index < _count; index ++){
+        if(_dirty[index / 8] & (1 << (index % 8))) count ++;
+    }
+    return count;
+}
+
+unsigned int W25Q64_Merkle::_halfAddress(unsigned int half){
+    return (_meta + half * metaSectors(_count) / 2) * W25Q64_SECTOR_SIZE;
+}
+
+unsigned int W25Q64_Merkle::_bitmapPages(){
+    return (_count + W25Q64_MERKLE_BITS_PER_PAGE - 1) / W25Q64_MERKLE_BITS_PER_PAGE;
+}
+
+bool W25Q64_Merkle::_loadHalf(unsigned int half, W25Q64_Merkle_header_t* header){
+    _flash->waitWhileBusy();
+    if(_flash->fastRead(_halfAddress(half), (byte*)header, sizeof(*header)) != W25Q64_OK) return false;
+    if(header->magic != W25Q64_MERKLE_MAGIC) return false;
+    if(W25Q64_crc32((byte*)header, sizeof(*header) - sizeof(header->crc)) != header->crc) return false;
+    if(header->first_sector != _first || header->count != _count) return false;
+    // the leaf table has to be intact too, a commit cut short never got its header
+    uint32_t crc = W25Q64_CRC32_INIT;
+    byte buff[W25Q64_PAGE_SIZE];
+    unsigned int addr = _halfAddress(half) + (1 + _bitmapPages()) * W25Q64_PAGE_SIZE;
+    for(unsigned int left = _count * 4; left > 0;){
+        unsigned int n = left < W25Q64_PAGE_SIZE ? left : W25Q64_PAGE_SIZE;
+        if(W25Q64_crc32Read(_flash, addr, buff, n, &crc) != W25Q64_OK) return false;
+        addr += n;
+        left -= n;
+    }
+    return ~crc == header->leaves_crc;
+}
+
+W25Q64_status_t W25Q64_Merkle::_hashSector(unsigned int index, uint32_t* hash){
+    uint32_t crc = W25Q64_CRC32_INIT;
+    byte buff[W25Q64_PAGE_SIZE];
+    unsigned int addr = (_first + index) * W25Q64_SECTOR_SIZE;
+    _flash->waitWhileBusy();
+    for(unsigned int page = 0; page < W25Q64_SECTOR_SIZE / W25Q64_PAGE_SIZE; page ++){
+        W25Q64_status_t status = W25Q64_crc32Read(_flash, addr + page * W25Q64_PAGE_SIZE, buff, W25Q64_PAGE_SIZE, &crc);
+        if(status != W25Q64_OK) return status;
+    }
+    *hash = ~crc;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Merkle::_commit(bool all){
+    unsigned int target = _loaded ? _half ^ 1 : 0;
+    unsigned int base = _halfAddress(target);
+    unsigned int leaf_addr = base + (1 + _bitmapPages()) * W25Q64_PAGE_SIZE;
+    unsigned int old_addr = _halfAddress(_half) + (1 + _bitmapPages()) * W25Q64_PAGE_SIZE;
+    bool rehash_all = all || !_loaded;
+    W25Q64_status_t status;
+    for(unsigned int sector = 0; sector < metaSectors(_count) / 2; sector ++){
+        status = _flash->erase(base + sector * W25Q64_SECTOR_SIZE);
+        if(status != W25Q64_OK) return status;
+    }
+    uint32_t old_leaves[W25Q64_MERKLE_LEAVES_PER_PAGE];
+    uint32_t new_leaves[W25Q64_MERKLE_LEAVES_PER_PAGE];
+    uint32_t nodes[W25Q64_MERKLE_MAX_DEPTH + 1];
+    unsigned int levels[W25Q64_MERKLE_MAX_DEPTH + 1];
+    unsigned int depth = 0;
+    uint32_t leaves_crc = W25Q64_CRC32_INIT;
+    for(unsigned int index = 0; index < _count; index ++){
+        unsigned int slot = index % W25Q64_MERKLE_LEAVES_PER_PAGE;
+        if(slot == 0 && !rehash_all){
+            unsigned int len = (_count - index) * 4;
+            if(len > sizeof(old_leaves)) len = sizeof(old_leaves);
+            _flash->waitWhileBusy();
+            status = _flash->fastRead(old_addr + index * 4, (byte*)old_leaves, len);
+            if(status != W25Q64_OK) return status;
+        }
+        // only dirty sectors are read, the rest keep their leaf
+        if(rehash_all || (_dirty[index / 8] & (1 << (index % 8)))){
+            status = _hashSector(index, &new_leaves[slot]);
+            if(status != W25Q64_OK) return status;
+        }
+        else{
+            new_leaves[slot] = old_leaves[slot];
+        }
+        _merklePush(nodes, levels, &depth, new_leaves[slot]);
+        if(slot == W25Q64_MERKLE_LEAVES_PER_PAGE - 1 || index == _count - 1){
+            unsigned int len = (slot + 1) * 4;
+            leaves_crc = W25Q64_crc32Update(leaves_crc, (byte*)new_leaves, len);
+            status = _flash->program(leaf_addr + (index - slot) * 4, (byte*)new_leaves, len);
+            if(status != W25Q64_OK) return status;
+        }
+    }
+    // pad to a power of two with zero leaves
+    unsigned int width = 1;
+    while(width < _count) width *= 2;
+    for(unsigned int index = _count; index < width; index ++){
+        _merklePush(nodes, levels, &depth, 0);
+    }
+    W25Q64_Merkle_header_t header;
+    header.magic = W25Q64_MERKLE_MAGIC;
+    header.sequence = _loaded ? _header.sequence + 1 : 1;
+    header.first_sector = _first;
+    header.count = _count;
+    header.root = nodes[0];
+    header.leaves_crc = ~leaves_crc;
+    header.crc = W25Q64_crc32((byte*)&header, sizeof(header) - sizeof(header.crc));
+    // the header goes last, it is what makes the commit count
+    status = _flash->program(base, (byte*)&header, sizeof(header));
+    if(status != W25Q64_OK) return status;
+    _header = header;
+    _half = target;
+    _loaded = true;
+    memset(_dirty, 0, sizeof(_dirty));
+    _unsynced = false;
+    return W25Q64_OK;
+}
@@ -0,0 +1,179 @@
+/**
+ * @file W25Q64_Merkle.hpp
+ * @author Jeremy Dunne
+ * @brief Incremental hash tree over W25Q64 sectors
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_MERKLE_HPP_
+#define _W25Q64_MERKLE_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+#include "W25Q64_CRC.hpp"
+
+
+// hash tree settings
+#define W25Q64_MERKLE_MAX_SECTORS           W25Q64_SECTOR_COUNT // most sectors one tree covers
+#define W25Q64_MERKLE_MAGIC                 0x4C4B524D // "MRKL"
+#define W25Q64_MERKLE_MAX_DEPTH             12 // levels below the root, 2^depth >= W25Q64_MERKLE_MAX_SECTORS
+
+/**
+ * @brief header at the start of each metadata half
+ *
+ */
+typedef struct{
+    uint32_t magic;             ///< W25Q64_MERKLE_MAGIC
+    uint32_t sequence;          ///< commit sequence, the valid half with the highest one is used
+    uint16_t first_sector;      ///< first sector covered
+    uint16_t count;             ///< sectors covered
+    uint32_t root;              ///< root of the tree over the leaf table
+    uint32_t leaves_crc;        ///< CRC32 of the leaf table
+    uint32_t crc;               ///< CRC32 of everything above
+} W25Q64_Merkle_header_t;
+
+/**
+ * @brief hash tree with one CRC32 leaf per sector, updated only where sectors changed
+ *
+ * The leaf table and the root are kept in a metadata region split into two halves, a commit writes the new table into
+ *  the idle half and its header last, so a reset during update() leaves the previous commit in place. The tree observes
+ *  the chip: every program or erase that touches a covered sector marks it dirty, and sync() saves the dirty marks by
+ *  clearing bits in a bitmap page of the active half, no erase needed. update() then rehashes only the dirty sectors,
+ *  takes every other leaf from the table and rebuilds the root from the leaves, so checking an image against a known root
+ *  after a few sectors changed reads a few sectors plus the leaf table instead of the whole image.
+ *
+ *  Inner nodes are the CRC32 of their two children, a tree over a count that is not a power of two is padded with zero
+ *  leaves. CRC32 finds corruption, not tampering.
+ *
+ */
+class W25Q64_Merkle : public W25Q64_Observer{
+public:
+    /**
+     * @brief set up the tree and load the last commit
+     *
+     * @param flash initialized flash chip
+     * @param first_sector first sector covered
+     * @param count number of sectors covered, at most W25Q64_MERKLE_MAX_SECTORS
+     * @param meta_sector first of metaSectors(count) sectors for the metadata, outside the covered range
+     * @return W25Q64_status_t W25Q64_NOT_FOUND if there is no commit yet, call build()
+     */
+    W25Q64_status_t init(W25Q64* flash, unsigned int first_sector, unsigned int count, unsigned int meta_sector);
+
+    /**
+     * @brief get the number of metadata sectors a tree needs
+     *
+     * @param count number of sectors covered
+     * @return unsigned int sectors of metadata, both halves
+     */
+    static unsigned int metaSectors(unsigned int count);
+
+    /**
+     * @brief hash every covered sector and commit
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t build();
+
+    /**
+     * @brief rehash the dirty sectors and commit the new root
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t update();
+
+    /**
+     * @brief update and compare the root against a trusted one
+     *
+     * @param expected root the covered sectors should hash to
+     * @return W25Q64_status_t W25Q64_CORRUPT on a mismatch
+     */
+    W25Q64_status_t verify(uint32_t expected);
+
+    /**
+     * @brief rehash one sector and compare it against its leaf, for spot checks of clean sectors
+     *
+     * @param sector covered sector
+     * @return W25Q64_status_t W25Q64_CORRUPT on a mismatch
+     */
+    W25Q64_status_t verifySector(unsigned int sector);
+
+    /**
+     * @brief save the dirty marks collected since the last sync
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t sync();
+
+    /**
+     * @brief mark the covered sectors a program or erase touched, called by the chip
+     *
+     * @param kind what happened to the range
+     * @param addr start of the range
+     * @param data bytes programmed, NULL for an erase
+     * @param len length of the range
+     */
+    void mutated(W25Q64_mutation_t kind, unsigned int addr, const byte* data, unsigned int len);
+
+    /**
+     * @brief get the root of the last commit
+     *
+     * @return uint32_t root
+     */
+    uint32_t root(){return _header.root;};
+
+    /**
+     * @brief get the number of sectors waiting to be rehashed
+     *
+     * @return unsigned int dirty sectors
+     */
+    unsigned int dirty();
+
+private:
+    W25Q64* _flash; ///< flash chip used
+    unsigned int _first; ///< first sector covered
+    unsigned int _count; ///< sectors covered
+    unsigned int _meta; ///< first metadata sector
+    unsigned int _half; ///< metadata half of the last commit
+    W25Q64_Merkle_header_t _header; ///< header of the last commit
+    byte _dirty[W25Q64_MERKLE_MAX_SECTORS / 8]; ///< dirty sectors, a set bit needs rehashing
+    bool _unsynced; ///< dirty bits set since the last sync()
+    bool _loaded; ///< true once there is a commit
+
+    /**
+     * @brief get the address of a metadata half
+     *
+     */
+    unsigned int _halfAddress(unsigned int half);
+
+    /**
+     * @brief get the number of bitmap pages at the start of a half, after the header page
+     *
+     */
+    unsigned int _bitmapPages();
+
+    /**
+     * @brief read and check the header and leaf table of a half
+     *
+     */
+    bool _loadHalf(unsigned int half, W25Q64_Merkle_header_t* header);
+
+    /**
+     * @brief compute the CRC32 of a covered sector
+     *
+     */
+    W25Q64_status_t _hashSector(unsigned int index, uint32_t* hash);
+
+    /**
+     * @brief write a new leaf table into the idle half, rehashing dirty sectors or all of them, and commit it
+     *
+     */
+    W25Q64_status_t _commit(bool all);
+};
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * @file W25Q64_Mirror.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 mirroring
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_Mirror.hpp"
+
+W25Q64_status_t W25Q64_Mirror::init(W25Q64* primary, W25Q64* secondary){
+    _chips[0] = primary;
+    _chips[1] = secondary;
+    _next = 0;
+    _erasing = false;
+    _mismatches = 0;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Mirror::read(unsigned int addr, byte* buff, unsigned int len){
+    if(addr + len > W25Q64_MAX_ADDRESS + 1) return W25Q64_INVALID_ADDRESS;
+    return _chips[_pickChip()]->fastRead(addr, buff, len);
+}
+
+W25Q64_status_t W25Q64_Mirror::readVerified(unsigned int addr, byte* buff, unsigned int len, uint32_t crc){
+    if(addr + len > W25Q64_MAX_ADDRESS + 1) return W25Q64_INVALID_ADDRESS;
+    unsigned int chip = _pickChip();
+    W25Q64_status_t status = _chips[chip]->fastRead(addr, buff, len);
+    if(status != W25Q64_OK) return status;
+    if(W25Q64_crc32(buff, len) == crc) return W25Q64_OK;
+    _mismatches ++;
+    // the other copy may be mid erase, wait for it rather than read a half erased sector
+    chip ^= 1;
+    _chips[chip]->waitWhileBusy();
+    status = _chips[chip]->fastRead(addr, buff, len);
+    if(status != W25Q64_OK) return status;
+    if(W25Q64_crc32(buff, len) == crc) return W25Q64_OK;
+    _mismatches ++;
+    return W25Q64_CORRUPT;
+}
+
+W25Q64_status_t W25Q64_Mirror::write(unsigned int addr, byte* buff, unsigned int len){
+    if(addr + len > W25Q64_MAX_ADDRESS + 1) return W25Q64_INVALID_ADDRESS;
+    W25Q64_status_t status = _finishErase();
+    if(status != W25Q64_OK) return status;
+    while(len > 0){
+        unsigned int n = W25Q64_PAGE_SIZE - addr % W25Q64_PAGE_SIZE;
+        if(n > len) n = len;
+        // the second chip receives the page while the first one programs it
+        for(unsigned int i = 0; i < 2; i ++){
+            _chips[i]->waitWhileBusy();
+            _chips[i]->writeEnable();
+            status = _chips[i]->pageProgram(addr, buff, n);
+            if(status != W25Q64_OK) return status;
+        }
+        addr += n;
+        buff += n;
+        len -= n;
+    }
+    _chips[0]->waitWhileBusy();
+    return _chips[1]->waitWhileBusy();
+}
+
+W25Q64_status_t W25Q64_Mirror::erase(unsigned int addr, unsigned int len){
+    W25Q64_status_t status = startErase(addr, len);
+    if(status != W25Q64_OK) return status;
+    return _finishErase();
+}
+
+W25Q64_status_t W25Q64_Mirror::startErase(unsigned int addr, unsigned int len){
+    if(addr % W25Q64_SECTOR_SIZE != 0 || len % W25Q64_SECTOR_SIZE != 0) return W25Q64_INVALID_ADDRESS;
+    if(addr + len > W25Q64_MAX_ADDRESS + 1) return W25Q64_INVALID_ADDRESS;
+    W25Q64_status_t status = _finishErase();
+    if(status != W25Q64_OK) return status;
+    if(len == 0) return W25Q64_OK;
+    _erase_addr = addr;
+    _erase_end = addr + len;
+    _erase_chip = 0;
+    _erasing = true;
+    return _eraseSector();
+}
+
+W25Q64_status_t W25Q64_Mirror::poll(){
+    if(!_erasing) return W25Q64_OK;
+    if(_chips[_erase_chip]->busy()) return W25Q64_BUSY;
+    // a sector is erased on the second chip only once the first copy is gone, then the next sector starts
+    if(_erase_chip == 0){
+        _erase_chip = 1;
+    }
+    else{
+        _erase_chip = 0;
+        _erase_addr += W25Q64_SECTOR_SIZE;
+        if(_erase_addr >= _erase_end){
+            _erasing = false;
+            return W25Q64_OK;
+        }
+    }
+    W25Q64_status_t status = _eraseSector();
+    if(status != W25Q64_OK) return status;
+    return W25Q64_BUSY;
+}
+
+unsigned int W25Q64_Mirror::_pickChip(){
+    while(true){
+        unsigned int chip = _next;
+        _next ^= 1;
+        if(!_chips[chip]->busy()) return chip;
+        if(!_chips[chip ^ 1]->busy()) return chip ^ 1;
+        yield();
+    }
+}
+
+W25Q64_status_t W25Q64_Mirror::_eraseSector(){
+    _chips[_erase_chip]->waitWhileBusy();
+    _chips[_erase_chip]->writeEnable();
+    return _chips[_erase_chip]->sectorErase(_erase_addr);
+}
+
+W25Q64_status_t W25Q64_Mirror::_finishErase(){
+    while(_erasing){
+        W25Q64_status_t status = poll();
+        if(status == W25Q64_BUSY) yield();
+        else if(status != W25Q64_OK) return status;
+    }
+    return W25Q64_OK;
+}
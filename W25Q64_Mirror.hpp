@@ -0,0 +1,137 @@
+/**
+ * @file W25Q64_Mirror.hpp
+ * @author Jeremy Dunne
+ * @brief RAID-1 style mirroring over two W25Q64 chips
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_MIRROR_HPP_
+#define _W25Q64_MIRROR_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+#include "W25Q64_CRC.hpp"
+
+
+/**
+ * @brief two chips holding the same data
+ *
+ * Writes program the page on the first chip and, while it is in tPP, send the same page to the second. Erases are
+ *  staggered, a sector is only erased on the second chip once the first has finished, so one copy is always intact and
+ *  one chip is always free to serve reads. Reads go to a chip that is not busy, alternating when both are idle, and a
+ *  read checked against a CRC falls back to the other copy on a mismatch.
+ *
+ */
+class W25Q64_Mirror{
+public:
+    /**
+     * @brief set up the mirror
+     *
+     * @param primary initialized chip
+     * @param secondary initialized chip on its own chip select
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t init(W25Q64* primary, W25Q64* secondary);
+
+    /**
+     * @brief read from whichever chip is free
+     *
+     * @param addr address to read from
+     * @param buff buffer to read into
+     * @param len number of bytes
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t read(unsigned int addr, byte* buff, unsigned int len);
+
+    /**
+     * @brief read and check against a CRC32, trying the other copy on a mismatch
+     *
+     * @param addr address to read from
+     * @param buff buffer to read into
+     * @param len number of bytes
+     * @param crc expected W25Q64_crc32 of the data
+     * @return W25Q64_status_t W25Q64_CORRUPT if neither copy matches
+     */
+    W25Q64_status_t readVerified(unsigned int addr, byte* buff, unsigned int len, uint32_t crc);
+
+    /**
+     * @brief program erased memory on both chips, any length and alignment
+     *
+     * Waits for a background erase to finish first
+     *
+     * @param addr address to program
+     * @param buff data to program
+     * @param len number of bytes
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t write(unsigned int addr, byte* buff, unsigned int len);
+
+    /**
+     * @brief erase sectors on both chips and wait for it
+     *
+     * @param addr sector aligned address
+     * @param len number of bytes, a multiple of the sector size
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t erase(unsigned int addr, unsigned int len);
+
+    /**
+     * @brief start erasing sectors on both chips in the background
+     *
+     * poll() moves the erase on, reads are served from the chip that is not erasing meanwhile
+     *
+     * @param addr sector aligned address
+     * @param len number of bytes, a multiple of the sector size
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t startErase(unsigned int addr, unsigned int len);
+
+    /**
+     * @brief move a background erase on
+     *
+     * @return W25Q64_status_t W25Q64_BUSY while the erase is still running
+     */
+    W25Q64_status_t poll();
+
+    /**
+     * @brief get the number of reads that failed their CRC on one chip
+     *
+     * @return unsigned long mismatches
+     */
+    unsigned long mismatches(){return _mismatches;};
+
+private:
+    W25Q64* _chips[2]; ///< the two copies
+    unsigned int _next; ///< chip to read from when both are idle
+    bool _erasing; ///< true while a background erase runs
+    unsigned int _erase_addr; ///< sector being erased
+    unsigned int _erase_end; ///< end of the range being erased
+    unsigned int _erase_chip; ///< chip erasing _erase_addr
+    unsigned long _mismatches; ///< reads that failed their CRC
+
+    /**
+     * @brief pick a chip that is not busy, waiting for one if both are
+     *
+     */
+    unsigned int _pickChip();
+
+    /**
+     * @brief start the erase of _erase_addr on _erase_chip
+     *
+     */
+    W25Q64_status_t _eraseSector();
+
+    /**
+     * @brief wait for a background erase to complete, yielding between polls
+     *
+     */
+    W25Q64_status_t _finishErase();
+};
+
+#endif
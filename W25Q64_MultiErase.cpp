@@ -0,0 +1,110 @@
+/**
+ * @file W25Q64_MultiErase.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 parallel erase dispatcher
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_MultiErase.hpp"
+
+#define W25Q64_MULTIERASE_CHIP_SIZE         (W25Q64_MAX_ADDRESS + 1)
+
+W25Q64_status_t W25Q64_MultiErase::init(W25Q64** chips, unsigned int count){
+    if(count == 0 || count > W25Q64_MULTIERASE_MAX_CHIPS) return W25Q64_INVALID_ARGUMENT;
+    _count = count;
+    _next = 0;
+    for(unsigned int i = 0; i < count; i ++){
+        _chips[i] = chips[i];
+        _queued[i] = 0;
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_MultiErase::add(unsigned int chip, unsigned int addr, unsigned int len){
+    if(chip >= _count) return W25Q64_INVALID_ARGUMENT;
+    if(addr % W25Q64_SECTOR_SIZE != 0 || len % W25Q64_SECTOR_SIZE != 0) return W25Q64_INVALID_ADDRESS;
+    if(addr + len > W25Q64_MULTIERASE_CHIP_SIZE) return W25Q64_INVALID_ADDRESS;
+    if(len == 0) return W25Q64_OK;
+    if(_queued[chip] >= W25Q64_MULTIERASE_MAX_JOBS) return W25Q64_FULL;
+    _jobs[chip][_queued[chip]].addr = addr;
+    _jobs[chip][_queued[chip]].end = addr + len;
+    _queued[chip] ++;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_MultiErase::wipe(){
+    for(unsigned int i = 0; i < _count; i ++){
+        W25Q64_status_t status = add(i, 0, W25Q64_MULTIERASE_CHIP_SIZE);
+        if(status != W25Q64_OK) return status;
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_MultiErase::poll(){
+    bool busy = false;
+    for(unsigned int n = 0; n < _count; n ++){
+        unsigned int chip = (_next + n) % _count;
+        if(_chips[chip]->busy()){
+            busy = true;
+            continue;
+        }
+        if(_queued[chip] == 0) continue;
+        W25Q64_status_t status = _start(chip);
+        if(status != W25Q64_OK) return status;
+        busy = true;
+    }
+    // start somewhere else next time so no chip waits behind the others
+    _next = (_next + 1) % _count;
+    return busy ? W25Q64_BUSY : W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_MultiErase::run(){
+    W25Q64_status_t status;
+    while((status = poll()) == W25Q64_BUSY){
+        yield();
+    }
+    return status;
+}
+
+bool W25Q64_MultiErase::chipBusy(unsigned int chip){
+    if(chip >= _count) return false;
+    return _queued[chip] > 0 || _chips[chip]->busy();
+}
+
+W25Q64_status_t W25Q64_MultiErase::_start(unsigned int chip){
+    W25Q64_MultiErase_job_t* job = &_jobs[chip][0];
+    unsigned int left = job->end - job->addr;
+    unsigned int size;
+    W25Q64_status_t status;
+    _chips[chip]->writeEnable();
+    if(job->addr == 0 && left == W25Q64_MULTIERASE_CHIP_SIZE){
+        size = left;
+        status = _chips[chip]->chipErase();
+    }
+    else if(job->addr % W25Q64_BLOCK_64_SIZE == 0 && left >= W25Q64_BLOCK_64_SIZE){
+        size = W25Q64_BLOCK_64_SIZE;
+        status = _chips[chip]->block64Erase(job->addr);
+    }
+    else if(job->addr % W25Q64_BLOCK_32_SIZE == 0 && left >= W25Q64_BLOCK_32_SIZE){
+        size = W25Q64_BLOCK_32_SIZE;
+        status = _chips[chip]->block32Erase(job->addr);
+    }
+    else{
+        size = W25Q64_SECTOR_SIZE;
+        status = _chips[chip]->sectorErase(job->addr);
+    }
+    if(status != W25Q64_OK) return status;
+    job->addr += size;
+    if(job->addr >= job->end){
+        // pop the finished range
+        for(unsigned int i = 1; i < _queued[chip]; i ++){
+            _jobs[chip][i - 1] = _jobs[chip][i];
+        }
+        _queued[chip] --;
+    }
+    return W25Q64_OK;
+}
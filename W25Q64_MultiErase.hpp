@@ -0,0 +1,107 @@
+/**
+ * @file W25Q64_MultiErase.hpp
+ * @author Jeremy Dunne
+ * @brief Parallel erase dispatcher for several W25Q64 chips
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_MULTIERASE_HPP_
+#define _W25Q64_MULTIERASE_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+
+
+// multi erase settings
+#define W25Q64_MULTIERASE_MAX_CHIPS         4 // max chips served
+#define W25Q64_MULTIERASE_MAX_JOBS          4 // max queued ranges per chip
+
+/**
+ * @brief range waiting to be erased
+ *
+ */
+typedef struct{
+    unsigned int addr;          ///< next address to erase
+    unsigned int end;           ///< end of the range
+} W25Q64_MultiErase_job_t;
+
+/**
+ * @brief erases ranges on several chips at the same time
+ *
+ * Every chip has a small queue of ranges. poll() walks the chips round-robin and, on every chip whose WIP bit is clear,
+ *  starts the largest erase the remaining range is aligned for (64 KB block, 32 KB block or sector, the whole chip for a
+ *  full wipe). Erases on different chips therefore overlap and wiping N chips takes about as long as one. Nothing waits
+ *  on a busy chip, so chips with nothing queued keep serving reads; chipBusy() tells a caller which ones those are.
+ *
+ */
+class W25Q64_MultiErase{
+public:
+    /**
+     * @brief set up the dispatcher
+     *
+     * @param chips initialized chips, each on its own chip select
+     * @param count number of chips, at most W25Q64_MULTIERASE_MAX_CHIPS
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t init(W25Q64** chips, unsigned int count);
+
+    /**
+     * @brief queue a range for erasing
+     *
+     * @param chip index of the chip
+     * @param addr sector aligned address
+     * @param len number of bytes, a multiple of the sector size
+     * @return W25Q64_status_t W25Q64_FULL if the chip's queue is full
+     */
+    W25Q64_status_t add(unsigned int chip, unsigned int addr, unsigned int len);
+
+    /**
+     * @brief queue every chip for a full erase
+     *
+     * @return W25Q64_status_t W25Q64_FULL if a queue is full
+     */
+    W25Q64_status_t wipe();
+
+    /**
+     * @brief start the next erase on every idle chip with work queued
+     *
+     * @return W25Q64_status_t W25Q64_BUSY while erases are queued or running, W25Q64_OK once all are done
+     */
+    W25Q64_status_t poll();
+
+    /**
+     * @brief run poll() until everything is erased
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t run();
+
+    /**
+     * @brief check if a chip has an erase queued or running
+     *
+     * @param chip index of the chip
+     * @return bool true if the chip can not serve reads right now
+     */
+    bool chipBusy(unsigned int chip);
+
+private:
+    W25Q64* _chips[W25Q64_MULTIERASE_MAX_CHIPS]; ///< chips served
+    unsigned int _count; ///< number of chips
+    unsigned int _next; ///< chip poll() looks at first
+    W25Q64_MultiErase_job_t _jobs[W25Q64_MULTIERASE_MAX_CHIPS][W25Q64_MULTIERASE_MAX_JOBS]; ///< queued ranges per chip
+    unsigned int _queued[W25Q64_MULTIERASE_MAX_CHIPS]; ///< ranges queued per chip
+
+    /**
+     * @brief start the largest erase that fits the head of a chip's queue
+     *
+     */
+    W25Q64_status_t _start(unsigned int chip);
+};
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * @file W25Q64_Queue.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 lock-free record queue
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_Queue.hpp"
+
+#define W25Q64_QUEUE_MASK                   (W25Q64_QUEUE_SIZE - 1)
+
+void W25Q64_Queue::clear(){
+    _head = 0;
+    _tail = 0;
+    _dropped = 0;
+}
+
+W25Q64_status_t W25Q64_Queue::push(const byte* data, unsigned int len){
+    unsigned int head = _head;
+    // the consumer's index is only read, pairs with its release store in pop()
+    unsigned int tail = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+    if(len > W25Q64_QUEUE_SIZE - (head - tail)){
+        _dropped ++;
+        return W25Q64_FULL;
+    }
+    unsigned int offset = head & W25Q64_QUEUE_MASK;
+    unsigned int first = W25Q64_QUEUE_SIZE - offset;
+    if(first > len) first = len;
+    memcpy(&_buff[offset], data, first);
+    memcpy(&_buff[0], data + first, len - first);
+    // publish the bytes only once they are in the ring
+    __atomic_store_n(&_head, head + len, __ATOMIC_RELEASE);
+    return W25Q64_OK;
+}
+
+unsigned int W25Q64_Queue::pop(byte* buff, unsigned int len){
+    unsigned int tail = _tail;
+    unsigned int head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+    if(len > head - tail) len = head - tail;
+    unsigned int offset = tail & W25Q64_QUEUE_MASK;
+    unsigned int first = W25Q64_QUEUE_SIZE - offset;
+    if(first > len) first = len;
+    memcpy(buff, &_buff[offset], first);
+    memcpy(buff + first, &_buff[0], len - first);
+    // hand the space back only once the bytes are copied out
+    __atomic_store_n(&_tail, tail + len, __ATOMIC_RELEASE);
+    return len;
+}
+
+unsigned int W25Q64_Queue::available(){
+    return __atomic_load_n(&_head, __ATOMIC_ACQUIRE) - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+}
+
+W25Q64_status_t W25Q64_QueueWriter::init(W25Q64* flash, W25Q64_Queue* queue, unsigned int addr, unsigned int len){
+    if(addr % W25Q64_SECTOR_SIZE != 0 || len % W25Q64_SECTOR_SIZE != 0) return W25Q64_INVALID_ADDRESS;
+    if(addr + len > W25Q64_MAX_ADDRESS + 1) return W25Q64_INVALID_ADDRESS;
+    _flash = flash;
+    _queue = queue;
+    _start = addr;
+    _end = addr + len;
+    _addr = addr;
+    _erased = addr;
+    _fill = 0;
+    _programmed = 0;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_QueueWriter::poll(){
+    return _step(false);
+}
+
+W25Q64_status_t W25Q64_QueueWriter::flush(){
+    while(true){
+        _flash->waitWhileBusy();
+        W25Q64_status_t status = _step(true);
+        if(status != W25Q64_OK && status != W25Q64_BUSY) return status;
+        if(_queue->available() == 0 && _fill == _programmed) break;
+    }
+    return _flash->waitWhileBusy();
+}
+
+W25Q64_status_t W25Q64_QueueWriter::_step(bool partial){
+    if(_flash->busy()) return W25Q64_BUSY;
+    if(_addr >= _end) return W25Q64_FULL;
+    if(_addr >= _erased){
+        // the stream reached a new sector, erase it before the page lands there
+        _flash->writeEnable();
+        W25Q64_status_t status = _flash->sectorErase(_erased);
+        if(status != W25Q64_OK) return status;
+        _erased += W25Q64_SECTOR_SIZE;
+        return W25Q64_OK;
+    }
+    _fill += _queue->pop(&_page[_fill], W25Q64_PAGE_SIZE - _fill);
+    if(_fill < W25Q64_PAGE_SIZE && !(partial && _fill > _programmed)) return W25Q64_BUSY;
+    _flash->writeEnable();
+    W25Q64_status_t status = _flash->pageProgram(_addr + _programmed, &_page[_programmed], _fill - _programmed);
+    if(status != W25Q64_OK) return status;
+    _programmed = _fill;
+    if(_fill == W25Q64_PAGE_SIZE){
+        _addr += W25Q64_PAGE_SIZE;
+        _fill = 0;
+        _programmed = 0;
+    }
+    return W25Q64_OK;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file W25Q64_Queue.hpp
+ * @author Jeremy Dunne
+ * @brief Lock-free record queue from interrupts to a W25Q64 writer task
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_QUEUE_HPP_
+#define _W25Q64_QUEUE_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+
+
+// queue settings
+#define W25Q64_QUEUE_SIZE                   1024 // bytes in the ring, a power of two
+
+/**
+ * @brief bounded single-producer/single-consumer byte ring
+ *
+ * One side, typically an ISR, only calls push(), the other, the flash task, only calls pop(). Each side owns one index and
+ *  only reads the other's, the indices are published with release stores and read with acquire loads, so neither side
+ *  ever waits or disables interrupts. Several ISRs feeding one queue count as one producer only if they can not preempt
+ *  each other.
+ *
+ */
+class W25Q64_Queue{
+public:
+    /**
+     * @brief empty the queue, not safe while either side is running
+     *
+     */
+    void clear();
+
+    /**
+     * @brief queue a record, producer side only
+     *
+     * Never blocks, the record is either queued whole or not at all
+     *
+     * @param data bytes of the record
+     * @param len length of the record
+     * @return W25Q64_status_t W25Q64_FULL if there is not room for all of it
+     */
+    W25Q64_status_t push(const byte* data, unsigned int len);
+
+    /**
+     * @brief take bytes off the queue, consumer side only
+     *
+     * @param buff buffer to copy into
+     * @param len max number of bytes to take
+     * @return unsigned int number of bytes taken
+     */
+    unsigned int pop(byte* buff, unsigned int len);
+
+    /**
+     * @brief get the number of bytes queued
+     *
+     * @return unsigned int bytes queued
+     */
+    unsigned int available();
+
+    /**
+     * @brief get the number of records refused because the queue was full
+     *
+     * @return unsigned long dropped records
+     */
+    unsigned long dropped(){return _dropped;};
+
+private:
+    byte _buff[W25Q64_QUEUE_SIZE]; ///< ring storage
+    unsigned int _head = 0; ///< free running count of bytes pushed, written by the producer only
+    unsigned int _tail = 0; ///< free running count of bytes popped, written by the consumer only
+    unsigned long _dropped = 0; ///< records refused, written by the producer only
+};
+
+/**
+ * @brief flash task side of a W25Q64_Queue
+ *
+ * Drains the queue into a region of the chip as one continuous byte stream. Bytes are gathered in a page buffer and only
+ *  programmed once a whole page is ready, so a stream of small records costs one program per page. Sectors are erased as
+ *  the stream reaches them. poll() never waits on the chip, it starts at most one program or erase and returns.
+ *
+ */
+class W25Q64_QueueWriter{
+public:
+    /**
+     * @brief set up the writer, the region is erased as it is written
+     *
+     * @param flash initialized flash chip
+     * @param queue queue to drain
+     * @param addr sector aligned start of the region
+     * @param len length of the region, a multiple of the sector size
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t init(W25Q64* flash, W25Q64_Queue* queue, unsigned int addr, unsigned int len);
+
+    /**
+     * @brief move queued bytes to flash, call from the flash task
+     *
+     * @return W25Q64_status_t W25Q64_OK if a program or erase was started, W25Q64_BUSY if the chip is busy or the page is
+     *  still filling, W25Q64_FULL once the region is used up
+     */
+    W25Q64_status_t poll();
+
+    /**
+     * @brief program everything queued, including a partial last page, and wait for it
+     *
+     * The rest of a partial page is programmed later, the chip allows it as long as no byte is programmed twice
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t flush();
+
+    /**
+     * @brief get the number of bytes written to the region
+     *
+     * @return unsigned int bytes on flash
+     */
+    unsigned int written(){return _addr - _start + _programmed;};
+
+private:
+    W25Q64* _flash; ///< flash chip used
+    W25Q64_Queue* _queue; ///< queue drained
+    unsigned int _start; ///< start of the region
+    unsigned int _end; ///< end of the region
+    unsigned int _addr; ///< address the page buffer starts at
+    unsigned int _erased; ///< end of the erased part of the region
+    byte _page[W25Q64_PAGE_SIZE]; ///< bytes gathered for the page at _addr
+    unsigned int _fill; ///< bytes in _page
+    unsigned int _programmed; ///< bytes of _page already programmed by flush()
+
+    /**
+     * @brief start the next program or erase if one is ready
+     *
+     * @param partial program a page that is not full yet
+     */
+    W25Q64_status_t _step(bool partial);
+};
+
+#endif
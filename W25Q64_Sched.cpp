@@ -0,0 +1,216 @@
+/**
+ * @file W25Q64_Sched.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 request scheduler
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_Sched.hpp"
+
+// end of the memory a request still touches
+#define W25Q64_SCHED_END(req)               ((req)->type == W25Q64_SCHED_ERASE ? (req)->addr + W25Q64_SECTOR_SIZE : (req)->addr + (req)->len)
+
+W25Q64_status_t W25Q64_Sched::init(W25Q64* flash){
+    _flash = flash;
+    _count = 0;
+    _misses = 0;
+    _completed = 0;
+    _pieces = 0;
+    _commands = 0;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Sched::read(W25Q64_Sched_request_t* req, unsigned int addr, byte* buff, unsigned int len, unsigned long deadline){
+    return _submit(req, W25Q64_SCHED_READ, addr, buff, len, deadline);
+}
+
+W25Q64_status_t W25Q64_Sched::write(W25Q64_Sched_request_t* req, unsigned int addr, byte* buff, unsigned int len, unsigned long deadline){
+    return _submit(req, W25Q64_SCHED_WRITE, addr, buff, len, deadline);
+}
+
+W25Q64_status_t W25Q64_Sched::erase(W25Q64_Sched_request_t* req, unsigned int addr, unsigned long deadline){
+    return _submit(req, W25Q64_SCHED_ERASE, addr - addr % W25Q64_SECTOR_SIZE, NULL, 0, deadline);
+}
+
+W25Q64_status_t W25Q64_Sched::poll(){
+    if(_count == 0) return W25Q64_OK;
+    if(_flash->busy()) return W25Q64_BUSY;
+    // the chip is idle, so every program or erase sent before has finished
+    for(int i = _count - 1; i >= 0; i --){
+        if(_queue[i]->sent) _finish(i, W25Q64_OK);
+    }
+    int index = _pick();
+    if(index >= 0){
+        switch(_queue[index]->type){
+            case W25Q64_SCHED_READ:
+                _read(index);
+                break;
+            case W25Q64_SCHED_WRITE:
+                _write(index);
+                break;
+            case W25Q64_SCHED_ERASE:
+                _erase(index);
+                break;
+        }
+    }
+    return _count == 0 ? W25Q64_OK : W25Q64_BUSY;
+}
+
+W25Q64_status_t W25Q64_Sched::run(){
+    while(poll() == W25Q64_BUSY){
+        yield();
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Sched::_submit(W25Q64_Sched_request_t* req, W25Q64_Sched_type_t type, unsigned int addr, byte* buff, unsigned int len, unsigned long deadline){
+    if(addr + len > W25Q64_MAX_ADDRESS + 1) return W25Q64_INVALID_ADDRESS;
+    if(_count >= W25Q64_SCHED_MAX_REQUESTS) return W25Q64_FULL;
+    req->type = type;
+    req->addr = addr;
+    req->buff = buff;
+    req->len = len;
+    req->deadline = millis() + deadline;
+    req->sent = false;
+    req->done = false;
+    req->status = W25Q64_OK;
+    _queue[_count] = req;
+    _count ++;
+    // nothing to send, finishes on the next poll
+    if(type != W25Q64_SCHED_ERASE && len == 0) req->sent = true;
+    return W25Q64_OK;
+}
+
+bool W25Q64_Sched::_blocked(unsigned int index){
+    W25Q64_Sched_request_t* req = _queue[index];
+    for(unsigned int i = 0; i < index; i ++){
+        W25Q64_Sched_request_t* earlier = _queue[i];
+        if(req->type == W25Q64_SCHED_READ && earlier->type == W25Q64_SCHED_READ) continue;
+        if(req->addr < W25Q64_SCHED_END(earlier) && earlier->addr < W25Q64_SCHED_END(req)) return true;
+    }
+    return false;
+}
+
+int W25Q64_Sched::_pick(){
+    unsigned long now = millis();
+    int best = -1;
+    int best_erase = -1;
+    for(unsigned int i = 0; i < _count; i ++){
+        if(_queue[i]->sent || _blocked(i)) continue;
+        if(_queue[i]->type == W25Q64_SCHED_ERASE){
+            if(best_erase < 0 || (long)(_queue[i]->deadline - _queue[best_erase]->deadline) < 0) best_erase = i;
+        }
+        else{
+            if(best < 0 || (long)(_queue[i]->deadline - _queue[best]->deadline) < 0) best = i;
+        }
+    }
+    if(best_erase < 0) return best;
+    if(best < 0) return best_erase;
+    // reads and writes go ahead of an erase until it has to start to make its own deadline
+    W25Q64_Sched_request_t* erase = _queue[best_erase];
+    bool urgent = (long)(erase->deadline - W25Q64_SCHED_ERASE_TIME - now) <= 0;
+    if(urgent && (long)(erase->deadline - _queue[best]->deadline) <= 0) return best_erase;
+    return best;
+}
+
+void W25Q64_Sched::_read(unsigned int index){
+    W25Q64_Sched_request_t* req = _queue[index];
+    if(req->len > W25Q64_SCHED_BURST_SIZE){
+        // too long to join anything, read it straight into its buffer
+        _pieces ++;
+        _commands ++;
+        _finish(index, _flash->fastRead(req->addr, req->buff, req->len));
+        return;
+    }
+    bool joined[W25Q64_SCHED_MAX_REQUESTS] = {false};
+    joined[index] = true;
+    unsigned int start = req->addr;
+    unsigned int end = req->addr + req->len;
+    bool grown = true;
+    while(grown){
+        grown = false;
+        for(unsigned int i = 0; i < _count; i ++){
+            W25Q64_Sched_request_t* other = _queue[i];
+            if(joined[i] || other->type != W25Q64_SCHED_READ || other->len == 0 || _blocked(i)) continue;
+            if(other->addr > end + W25Q64_SCHED_MAX_GAP || other->addr + other->len + W25Q64_SCHED_MAX_GAP < start) continue;
+            unsigned int new_start = other->addr < start ? other->addr : start;
+            unsigned int new_end = other->addr + other->len > end ? other->addr + other->len : end;
+            if(new_end - new_start > W25Q64_SCHED_BURST_SIZE) continue;
+            start = new_start;
+            end = new_end;
+            joined[i] = true;
+            grown = true;
+        }
+    }
+    W25Q64_status_t status = _flash->fastRead(start, _buff, end - start);
+    _commands ++;
+    // copy out and finish from the back so the indices stay valid
+    for(int i = _count - 1; i >= 0; i --){
+        if(!joined[i]) continue;
+        if(status == W25Q64_OK) memcpy(_queue[i]->buff, &_buff[_queue[i]->addr - start], _queue[i]->len);
+        _pieces ++;
+        _finish(i, status);
+    }
+}
+
+void W25Q64_Sched::_write(unsigned int index){
+    unsigned int page = _queue[index]->addr / W25Q64_PAGE_SIZE;
+    unsigned int low = W25Q64_PAGE_SIZE;
+    unsigned int high = 0;
+    bool joined[W25Q64_SCHED_MAX_REQUESTS] = {false};
+    // pick the pieces before any request is advanced, so overlaps are checked against the ranges as queued
+    for(unsigned int i = 0; i < _count; i ++){
+        W25Q64_Sched_request_t* req = _queue[i];
+        if(req->type != W25Q64_SCHED_WRITE || req->sent || req->addr / W25Q64_PAGE_SIZE != page || _blocked(i)) continue;
+        joined[i] = true;
+    }
+    memset(_buff, 0xFF, W25Q64_PAGE_SIZE);
+    for(unsigned int i = 0; i < _count; i ++){
+        if(!joined[i]) continue;
+        W25Q64_Sched_request_t* req = _queue[i];
+        unsigned int offset = req->addr % W25Q64_PAGE_SIZE;
+        unsigned int n = W25Q64_PAGE_SIZE - offset;
+        if(n > req->len) n = req->len;
+        memcpy(&_buff[offset], req->buff, n);
+        if(offset < low) low = offset;
+        if(offset + n > high) high = offset + n;
+        req->addr += n;
+        req->buff += n;
+        req->len -= n;
+        if(req->len == 0) req->sent = true;
+        _pieces ++;
+    }
+    _flash->writeEnable();
+    W25Q64_status_t status = _flash->pageProgram(page * W25Q64_PAGE_SIZE + low, &_buff[low], high - low);
+    _commands ++;
+    if(status == W25Q64_OK) return;
+    // every request with a piece in the page lost it, finish them all from the back so the indices stay valid
+    for(int i = _count - 1; i >= 0; i --){
+        if(joined[i]) _finish(i, status);
+    }
+}
+
+void W25Q64_Sched::_erase(unsigned int index){
+    _flash->writeEnable();
+    W25Q64_status_t status = _flash->sectorErase(_queue[index]->addr);
+    _commands ++;
+    _pieces ++;
+    if(status != W25Q64_OK) _finish(index, status);
+    else _queue[index]->sent = true;
+}
+
+void W25Q64_Sched::_finish(unsigned int index, W25Q64_status_t status){
+    W25Q64_Sched_request_t* req = _queue[index];
+    for(unsigned int i = index + 1; i < _count; i ++){
+        _queue[i - 1] = _queue[i];
+    }
+    _count --;
+    _completed ++;
+    if((long)(millis() - req->deadline) > 0) _misses ++;
+    req->status = status;
+    req->done = true;
+}
@@ -0,0 +1,197 @@
+/**
+ * @file W25Q64_Sched.hpp
+ * @author Jeremy Dunne
+ * @brief Deadline aware request scheduler for the W25Q64
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_SCHED_HPP_
+#define _W25Q64_SCHED_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+
+
+// scheduler settings
+#define W25Q64_SCHED_MAX_REQUESTS           16 // max requests queued at once
+#define W25Q64_SCHED_BURST_SIZE             512 // max bytes of one merged read
+#define W25Q64_SCHED_MAX_GAP                16 // max unrequested bytes read to join two reads
+#define W25Q64_SCHED_ERASE_TIME             50 // ms a sector erase is expected to hold the chip
+
+/**
+ * @brief kinds of request
+ *
+ */
+typedef enum{
+    W25Q64_SCHED_READ = 0,      ///< read into a buffer
+    W25Q64_SCHED_WRITE,         ///< program erased memory
+    W25Q64_SCHED_ERASE          ///< erase a sector
+} W25Q64_Sched_type_t;
+
+/**
+ * @brief request owned by the caller, must stay valid until done is set
+ *
+ */
+typedef struct{
+    W25Q64_Sched_type_t type;   ///< kind of request
+    unsigned int addr;          ///< next address to work on
+    byte* buff;                 ///< next byte to read or program
+    unsigned int len;           ///< bytes left
+    unsigned long deadline;     ///< millis() the request should be done by
+    unsigned int tag;           ///< free for the caller, never touched by the scheduler
+    bool sent;                  ///< everything is sent, waiting for the chip to finish
+    volatile bool done;         ///< set once the request is finished
+    W25Q64_status_t status;     ///< result, valid once done is set
+} W25Q64_Sched_request_t;
+
+/**
+ * @brief queue of reads, writes and erases served earliest deadline first
+ *
+ * poll() sends one command each time the chip is idle. Reads that touch or nearly touch each other are joined into one
+ *  fastRead() burst and copied out, writes that land in the same page are combined into one page program (the bytes
+ *  between them are programmed as 0xFF, which leaves them erased). Erases hold the chip for a long time, so one is only
+ *  started when nothing else is queued or when waiting any longer would miss its own deadline. A request is never moved
+ *  ahead of an earlier one it overlaps, so reads always see the writes and erases queued before them.
+ *
+ */
+class W25Q64_Sched{
+public:
+    /**
+     * @brief set up the scheduler
+     *
+     * @param flash initialized flash chip
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t init(W25Q64* flash);
+
+    /**
+     * @brief queue a read
+     *
+     * @param req request to fill in and queue
+     * @param addr address to read from
+     * @param buff buffer to read into
+     * @param len number of bytes
+     * @param deadline ms from now the read should be done in
+     * @return W25Q64_status_t W25Q64_FULL if the queue is full
+     */
+    W25Q64_status_t read(W25Q64_Sched_request_t* req, unsigned int addr, byte* buff, unsigned int len, unsigned long deadline);
+
+    /**
+     * @brief queue a program of erased memory
+     *
+     * @param req request to fill in and queue
+     * @param addr address to program
+     * @param buff data to program
+     * @param len number of bytes
+     * @param deadline ms from now the write should be done in
+     * @return W25Q64_status_t W25Q64_FULL if the queue is full
+     */
+    W25Q64_status_t write(W25Q64_Sched_request_t* req, unsigned int addr, byte* buff, unsigned int len, unsigned long deadline);
+
+    /**
+     * @brief queue a sector erase
+     *
+     * @param req request to fill in and queue
+     * @param addr address in the sector
+     * @param deadline ms from now the erase should be done in
+     * @return W25Q64_status_t W25Q64_FULL if the queue is full
+     */
+    W25Q64_status_t erase(W25Q64_Sched_request_t* req, unsigned int addr, unsigned long deadline);
+
+    /**
+     * @brief send the next command if the chip is idle
+     *
+     * @return W25Q64_status_t W25Q64_BUSY while requests are queued
+     */
+    W25Q64_status_t poll();
+
+    /**
+     * @brief run poll() until the queue is empty
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t run();
+
+    /**
+     * @brief get the number of requests finished after their deadline
+     *
+     * @return unsigned long deadline misses
+     */
+    unsigned long misses(){return _misses;};
+
+    /**
+     * @brief get the number of requests finished
+     *
+     * @return unsigned long finished requests
+     */
+    unsigned long completed(){return _completed;};
+
+    /**
+     * @brief get the average number of request pieces served per flash command
+     *
+     * @return float 1.0 without any merging
+     */
+    float mergeRatio(){return _commands == 0 ? 1.0f : (float)_pieces / _commands;};
+
+private:
+    W25Q64* _flash; ///< flash chip used
+    W25Q64_Sched_request_t* _queue[W25Q64_SCHED_MAX_REQUESTS]; ///< queued requests in submission order
+    unsigned int _count; ///< requests queued
+    unsigned long _misses; ///< requests finished late
+    unsigned long _completed; ///< requests finished
+    unsigned long _pieces; ///< request pieces served
+    unsigned long _commands; ///< read, program and erase commands sent
+    byte _buff[W25Q64_SCHED_BURST_SIZE]; ///< merged read burst or page being programmed
+
+    /**
+     * @brief fill in and queue a request
+     *
+     */
+    W25Q64_status_t _submit(W25Q64_Sched_request_t* req, W25Q64_Sched_type_t type, unsigned int addr, byte* buff, unsigned int len, unsigned long deadline);
+
+    /**
+     * @brief check if a request has to wait for an earlier one it overlaps
+     *
+     * @param index position of the request in the queue
+     */
+    bool _blocked(unsigned int index);
+
+    /**
+     * @brief pick the request to serve next
+     *
+     * @return int position in the queue, -1 if nothing can run
+     */
+    int _pick();
+
+    /**
+     * @brief serve a read and every read that can join its burst
+     *
+     */
+    void _read(unsigned int index);
+
+    /**
+     * @brief program the next page of a write and of every write to the same page
+     *
+     */
+    void _write(unsigned int index);
+
+    /**
+     * @brief send an erase
+     *
+     */
+    void _erase(unsigned int index);
+
+    /**
+     * @brief finish a request and take it off the queue
+     *
+     */
+    void _finish(unsigned int index, W25Q64_status_t status);
+};
+
+#endif
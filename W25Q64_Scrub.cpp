@@ -0,0 +1,241 @@
+/**
+ * @file W25Q64_Scrub.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 background scrubber
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_Scrub.hpp"
+
+#define W25Q64_SCRUB_RECORDS                (W25Q64_SECTOR_SIZE / sizeof(W25Q64_Scrub_record_t))
+#define W25Q64_SCRUB_SLOTS                  (2 * W25Q64_SCRUB_RECORDS)
+
+W25Q64_status_t W25Q64_Scrub::init(W25Q64* flash, W25Q64_ECC* ecc, unsigned int progress_sector, unsigned int spare, unsigned long bytes_per_second){
+    if(ecc->sectorCount() < 2 || spare >= ecc->sectorCount()) return W25Q64_INVALID_ARGUMENT;
+    if(progress_sector + 2 > W25Q64_SECTOR_COUNT || bytes_per_second == 0) return W25Q64_INVALID_ARGUMENT;
+    _flash = flash;
+    _ecc = ecc;
+    _progress_sector = progress_sector;
+    _spare = spare;
+    _interval = (unsigned long)W25Q64_PAGE_SIZE * 1000000UL / bytes_per_second;
+    _accounted = micros();
+    _page = 0;
+    _sector_corrected = 0;
+    _sector_failed = false;
+    _refreshed = 0;
+    _failed = 0;
+    _erasing = false;
+    _resumed_at = 0;
+
+    // the cursor is the newest intact record of either progress sector
+    memset(&_record, 0, sizeof(_record));
+    _record.state = W25Q64_SCRUB_SCANNING;
+    _slot = 0;
+    bool found = false;
+    _flash->waitWhileBusy();
+    for(unsigned int half = 0; half < 2; half ++){
+        W25Q64_Scrub_record_t record;
+        unsigned int slot;
+        if(!_lastRecord(half, &record, &slot)) continue;
+        if(found && record.sequence <= _record.sequence) continue;
+        memcpy(&_record, &record, sizeof(record));
+        _slot = (half * W25Q64_SCRUB_RECORDS + slot) % W25Q64_SCRUB_SLOTS;
+        found = true;
+    }
+    // the spare holds a full copy, finish writing it back
+    if(_record.state == W25Q64_SCRUB_RESTORING) return _startErase(_record.sector);
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Scrub::poll(){
+    if(_flash->busy()) return W25Q64_BUSY;
+    _erasing = false;
+    // one page of budget per interval, at most W25Q64_SCRUB_BURST saved up
+    unsigned long now = micros();
+    if(now - _accounted > W25Q64_SCRUB_BURST * _interval) _accounted = now - W25Q64_SCRUB_BURST * _interval;
+    if(now - _accounted < _interval) return W25Q64_BUSY;
+    _accounted += _interval;
+    switch(_record.state){
+        case W25Q64_SCRUB_COPYING:
+            return _copy(_record.sector, _spare);
+        case W25Q64_SCRUB_RESTORING:
+            return _copy(_spare, _record.sector);
+        default:
+            return _scan();
+    }
+}
+
+W25Q64_status_t W25Q64_Scrub::_scan(){
+    if(_record.sector == _spare) return _advance();
+    unsigned long corrected = _ecc->corrected();
+    W25Q64_status_t status = _ecc->read((_record.sector * W25Q64_ECC_DATA_PAGES + _page) * W25Q64_PAGE_SIZE, _buff, W25Q64_PAGE_SIZE);
+    if(status == W25Q64_CORRUPT) _sector_failed = true;
+    else if(status != W25Q64_OK) return status;
+    _sector_corrected += _ecc->corrected() - corrected;
+    if(++ _page < W25Q64_ECC_DATA_PAGES) return W25Q64_OK;
+    // rewriting a sector with an uncorrectable page would hide the damage behind a fresh code
+    if(_sector_failed){
+        _failed ++;
+        return _advance();
+    }
+    if(_sector_corrected < W25Q64_SCRUB_THRESHOLD) return _advance();
+    _record.state = W25Q64_SCRUB_COPYING;
+    _page = 0;
+    return _startErase(_spare);
+}
+
+W25Q64_status_t W25Q64_Scrub::_copy(unsigned int from, unsigned int to){
+    W25Q64_status_t status = _ecc->read((from * W25Q64_ECC_DATA_PAGES + _page) * W25Q64_PAGE_SIZE, _buff, W25Q64_PAGE_SIZE);
+    if(status == W25Q64_CORRUPT && _record.state == W25Q64_SCRUB_COPYING){
+        // the sector got worse since the scan, leave it as it is
+        _failed ++;
+        return _advance();
+    }
+    if(status != W25Q64_OK && status != W25Q64_CORRUPT) return status;
+    bool blank = true;
+    for(unsigned int i = 0; i < W25Q64_PAGE_SIZE && blank; i ++){
+        if(_buff[i] != 0xFF) blank = false;
+    }
+    if(!blank){
+        status = _ecc->programPage(to * W25Q64_ECC_DATA_PAGES + _page, _buff);
+        if(status != W25Q64_OK) return status;
+    }
+    if(++ _page < W25Q64_ECC_DATA_PAGES) return W25Q64_OK;
+    _page = 0;
+    if(_record.state == W25Q64_SCRUB_RESTORING){
+        _refreshed ++;
+        return _advance();
+    }
+    // the spare holds the corrected copy, record that before the weak sector is erased
+    _record.state = W25Q64_SCRUB_RESTORING;
+    status = _save();
+    if(status != W25Q64_OK) return status;
+    return _startErase(_record.sector);
+}
+
+W25Q64_status_t W25Q64_Scrub::_advance(){
+    _record.sector ++;
+    if(_record.sector >= _ecc->sectorCount()){
+        _record.sector = 0;
+        _record.pass ++;
+    }
+    _record.state = W25Q64_SCRUB_SCANNING;
+    _page = 0;
+    _sector_corrected = 0;
+    _sector_failed = false;
+    return _save();
+}
+
+W25Q64_status_t W25Q64_Scrub::_save(){
+    W25Q64_status_t status;
+    if(_slot % W25Q64_SCRUB_RECORDS == 0){
+        // entering a progress sector, the other one keeps the newest record until this one has one
+        _flash->waitWhileBusy();
+        _flash->writeEnable();
+        status = _flash->sectorErase((_progress_sector + _slot / W25Q64_SCRUB_RECORDS) * W25Q64_SECTOR_SIZE);
+        if(status != W25Q64_OK) return status;
+        _flash->waitWhileBusy();
+    }
+    _record.sequence ++;
+    _record.crc = W25Q64_crc32((byte*)&_record, sizeof(_record) - sizeof(_record.crc));
+    _flash->waitWhileBusy();
+    _flash->writeEnable();
+    status = _flash->pageProgram(_progress_sector * W25Q64_SECTOR_SIZE + _slot * sizeof(_record), (byte*)&_record, sizeof(_record));
+    if(status != W25Q64_OK) return status;
+    _slot = (_slot + 1) % W25Q64_SCRUB_SLOTS;
+    return _flash->waitWhileBusy();
+}
+
+bool W25Q64_Scrub::_lastRecord(unsigned int half, W25Q64_Scrub_record_t* record, unsigned int* slot){
+    // records are appended in order, binary search for the first blank one
+    unsigned int base = (_progress_sector + half) * W25Q64_SECTOR_SIZE;
+    unsigned int low = 0;
+    unsigned int high = W25Q64_SCRUB_RECORDS;
+    while(low < high){
+        unsigned int mid = (low + high) / 2;
+        _flash->fastRead(base + mid * sizeof(*record), (byte*)record, sizeof(*record));
+        if(record->sector == W25Q64_SCRUB_BLANK) high = mid;
+        else low = mid + 1;
+    }
+    *slot = low;
+    // a torn last record falls back to the one before it
+    for(unsigned int i = low; i > 0 && i + 2 > low; i --){
+        _flash->fastRead(base + (i - 1) * sizeof(*record), (byte*)record, sizeof(*record));
+        if(record->crc != W25Q64_crc32((byte*)record, sizeof(*record) - sizeof(record->crc))) continue;
+        if(record->sector >= _ecc->sectorCount()) continue;
+        if(record->state == W25Q64_SCRUB_SCANNING || record->state == W25Q64_SCRUB_RESTORING) return true;
+    }
+    return false;
+}
+
+W25Q64_status_t W25Q64_Scrub::read(unsigned int addr, byte* buff, unsigned int len){
+    if(addr + len > _ecc->capacity()) return W25Q64_INVALID_ADDRESS;
+    const unsigned int sector_bytes = W25Q64_ECC_DATA_PAGES * W25Q64_PAGE_SIZE;
+    W25Q64_status_t result = W25Q64_OK;
+    bool suspended = _suspend();
+    while(len > 0){
+        unsigned int sector = addr / sector_bytes;
+        unsigned int n = sector_bytes - addr % sector_bytes;
+        if(n > len) n = len;
+        // the weak sector is erased or half written while it is restored, the spare holds all of it
+        unsigned int from = addr;
+        if(_record.state == W25Q64_SCRUB_RESTORING && sector == _record.sector) from = _spare * sector_bytes + addr % sector_bytes;
+        W25Q64_status_t status = _ecc->read(from, buff, n);
+        if(status == W25Q64_CORRUPT){
+            result = status;
+        }
+        else if(status != W25Q64_OK){
+            result = status;
+            break;
+        }
+        addr += n;
+        buff += n;
+        len -= n;
+    }
+    if(suspended) _resume();
+    return result;
+}
+
+W25Q64_status_t W25Q64_Scrub::programPage(unsigned int page, byte* buff){
+    // a page written into the sector under refresh would be lost when the spare is written back
+    if(_refreshing(page / W25Q64_ECC_DATA_PAGES)) return W25Q64_BUSY;
+    bool suspended = _suspend();
+    W25Q64_status_t status = _ecc->programPage(page, buff);
+    if(suspended) _resume();
+    return status;
+}
+
+W25Q64_status_t W25Q64_Scrub::eraseSector(unsigned int sector){
+    if(_refreshing(sector)) return W25Q64_BUSY;
+    // an erase can not run while another is suspended, this one waits for the scrub erase
+    return _ecc->eraseSector(sector);
+}
+
+W25Q64_status_t W25Q64_Scrub::_startErase(unsigned int sector){
+    W25Q64_status_t status = _ecc->startErase(sector);
+    if(status != W25Q64_OK) return status;
+    _erasing = true;
+    _resumed_at = micros();
+    return W25Q64_OK;
+}
+
+bool W25Q64_Scrub::_suspend(){
+    if(!_erasing || !_flash->busy()) return false;
+    // give the erase some time to progress since the last resume
+    while(micros() - _resumed_at < W25Q64_SCRUB_RESUME_INTERVAL_US){
+        yield();
+    }
+    _flash->eraseProgramSuspend();
+    // busy clears once the chip has entered the suspended state
+    _flash->waitWhileBusy();
+    return true;
+}
+
+void W25Q64_Scrub::_resume(){
+    _flash->eraseProgramResume();
+    _resumed_at = micros();
+}
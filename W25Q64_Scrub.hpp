@@ -0,0 +1,216 @@
+/**
+ * @file W25Q64_Scrub.hpp
+ * @author Jeremy Dunne
+ * @brief Rate limited background scrubber for the W25Q64 ECC store
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_SCRUB_HPP_
+#define _W25Q64_SCRUB_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+#include "W25Q64_ECC.hpp"
+#include "W25Q64_CRC.hpp"
+
+
+// scrub settings
+#define W25Q64_SCRUB_THRESHOLD              1 // corrected bit errors in a sector that trigger a refresh
+#define W25Q64_SCRUB_BURST                  4 // max pages the rate limiter saves up while idle
+#define W25Q64_SCRUB_BLANK                  0xFFFF // sector of an unwritten progress record
+#define W25Q64_SCRUB_RESUME_INTERVAL_US     100 // minimum time a scrub erase runs between two suspends so it keeps making progress
+
+/**
+ * @brief scrubber states
+ *
+ */
+typedef enum{
+    W25Q64_SCRUB_SCANNING = 0,      ///< reading the sector at the cursor
+    W25Q64_SCRUB_COPYING,           ///< copying a weak sector to the spare
+    W25Q64_SCRUB_RESTORING          ///< writing the spare back over the erased weak sector
+} W25Q64_Scrub_state_t;
+
+/**
+ * @brief progress record, appended to the progress sectors
+ *
+ */
+typedef struct{
+    uint16_t sector;            ///< store sector at the cursor
+    uint16_t state;             ///< W25Q64_Scrub_state_t, RESTORING once the spare holds a copy of sector
+    uint32_t pass;              ///< completed passes over the store
+    uint32_t sequence;          ///< save count, the intact record with the highest one is the cursor
+    uint32_t crc;               ///< CRC32 of everything above
+} W25Q64_Scrub_record_t;
+
+/**
+ * @brief idle time scrubber for a W25Q64_ECC store
+ *
+ * poll() reads at most one page per call and only when the byte budget of the configured rate allows it. Every page is
+ *  checked through the ECC layer; once a sector has collected W25Q64_SCRUB_THRESHOLD corrected bits it is refreshed:
+ *  copied corrected to a spare sector, erased and written back, one page per poll() with the erases left running in the
+ *  background. The cursor is appended to one of two progress sectors after every sector, ping-ponging to the other once
+ *  full, so a pass continues across reboots and a refresh cut short by a reset is finished from the spare.
+ *
+ *  While the scrubber runs the store is accessed through its read(), programPage() and eraseSector(). Reads of a sector
+ *  being written back are served from the spare, programs and erases of a sector under refresh are refused with
+ *  W25Q64_BUSY, and a scrub erase still running is suspended for the access instead of being waited out.
+ *
+ */
+class W25Q64_Scrub{
+public:
+    /**
+     * @brief initialize and recover the cursor
+     *
+     * @param flash initialized flash chip the store lives on
+     * @param ecc initialized ECC store to scrub
+     * @param progress_sector first of the two chip sectors holding the progress records, outside the store
+     * @param spare store sector reserved for refreshes, not used for data
+     * @param bytes_per_second bus budget of the scrubber
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t init(W25Q64* flash, W25Q64_ECC* ecc, unsigned int progress_sector, unsigned int spare, unsigned long bytes_per_second);
+
+    /**
+     * @brief do one unit of scrub work if the rate allows it, call from the idle loop
+     *
+     * @return W25Q64_status_t W25Q64_BUSY if the chip or the rate limit kept it from doing anything
+     */
+    W25Q64_status_t poll();
+
+    /**
+     * @brief read and correct data from the store, redirected to the spare while a sector is written back
+     *
+     * @param addr address in the store
+     * @param buff buffer to read into
+     * @param len number of bytes
+     * @return W25Q64_status_t W25Q64_CORRUPT if a page had more errors than can be corrected, the rest is still read
+     */
+    W25Q64_status_t read(unsigned int addr, byte* buff, unsigned int len);
+
+    /**
+     * @brief program a whole page of the store and its code, the page must be erased
+     *
+     * @param page page number in the store
+     * @param buff W25Q64_PAGE_SIZE bytes
+     * @return W25Q64_status_t W25Q64_BUSY if the page is in the sector being refreshed
+     */
+    W25Q64_status_t programPage(unsigned int page, byte* buff);
+
+    /**
+     * @brief erase a sector of the store and wait for it
+     *
+     * @param sector sector number in the store
+     * @return W25Q64_status_t W25Q64_BUSY if it is the sector being refreshed
+     */
+    W25Q64_status_t eraseSector(unsigned int sector);
+
+    /**
+     * @brief get the sector at the cursor
+     *
+     * @return unsigned int store sector
+     */
+    unsigned int position(){return _record.sector;};
+
+    /**
+     * @brief get the number of completed passes
+     *
+     * @return unsigned long passes over the whole store
+     */
+    unsigned long passes(){return _record.pass;};
+
+    /**
+     * @brief get the number of sectors refreshed since init
+     *
+     * @return unsigned long refreshed sectors
+     */
+    unsigned long refreshed(){return _refreshed;};
+
+    /**
+     * @brief get the number of sectors left alone because a page could not be corrected
+     *
+     * @return unsigned long sectors with uncorrectable pages
+     */
+    unsigned long failed(){return _failed;};
+
+private:
+    W25Q64* _flash; ///< underlying chip
+    W25Q64_ECC* _ecc; ///< store being scrubbed
+    unsigned int _progress_sector; ///< first of the two chip sectors of the progress records
+    unsigned int _spare; ///< store sector used for refreshes
+    unsigned long _interval; ///< microseconds of budget per page
+    unsigned long _accounted; ///< micros() the budget has been spent up to
+    unsigned int _slot; ///< next free progress record, counted across both progress sectors
+    W25Q64_Scrub_record_t _record; ///< current cursor
+    unsigned int _page; ///< page within the sector
+    unsigned long _sector_corrected; ///< corrected bits seen in the sector
+    bool _sector_failed; ///< true if a page of the sector could not be corrected
+    unsigned long _refreshed; ///< sectors refreshed
+    unsigned long _failed; ///< sectors skipped for uncorrectable pages
+    bool _erasing; ///< true while an erase started by the scrubber may still be running
+    unsigned long _resumed_at; ///< micros() of the last resume
+    byte _buff[W25Q64_PAGE_SIZE]; ///< page being checked or copied
+
+    /**
+     * @brief check the next page of the sector at the cursor
+     *
+     */
+    W25Q64_status_t _scan();
+
+    /**
+     * @brief copy the next page between the weak sector and the spare
+     *
+     */
+    W25Q64_status_t _copy(unsigned int from, unsigned int to);
+
+    /**
+     * @brief move the cursor to the next sector and save it
+     *
+     */
+    W25Q64_status_t _advance();
+
+    /**
+     * @brief append the cursor to the progress sectors
+     *
+     */
+    W25Q64_status_t _save();
+
+    /**
+     * @brief find the last record written to a progress sector
+     *
+     * @return bool true if the sector holds an intact record
+     */
+    bool _lastRecord(unsigned int half, W25Q64_Scrub_record_t* record, unsigned int* slot);
+
+    /**
+     * @brief start erasing a store sector and leave it running
+     *
+     */
+    W25Q64_status_t _startErase(unsigned int sector);
+
+    /**
+     * @brief check if a store sector is being refreshed
+     *
+     */
+    bool _refreshing(unsigned int sector){return _record.state != W25Q64_SCRUB_SCANNING && sector == _record.sector;};
+
+    /**
+     * @brief suspend a scrub erase if it is still running
+     *
+     * @return bool true if the erase was suspended and must be resumed
+     */
+    bool _suspend();
+
+    /**
+     * @brief resume the suspended scrub erase
+     *
+     */
+    void _resume();
+};
+
+#endif
@@ -0,0 +1,187 @@
+/**
+ * @file W25Q64_Slots.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 A/B firmware image slots
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_Slots.hpp"
+
+#define W25Q64_SLOTS_SECTOR_PAGES           (W25Q64_SECTOR_SIZE / W25Q64_PAGE_SIZE)
+#define W25Q64_SLOTS_META_SLOTS             (2 * W25Q64_SLOTS_SECTOR_PAGES)
+
+W25Q64_status_t W25Q64_Slots::init(W25Q64* flash, unsigned int meta_sector, unsigned int slot_sector, unsigned int slot_sectors){
+    if(slot_sectors == 0 || meta_sector + 2 > W25Q64_SECTOR_COUNT) return W25Q64_INVALID_ADDRESS;
+    if(slot_sector + W25Q64_SLOTS_COUNT * slot_sectors > W25Q64_SECTOR_COUNT) return W25Q64_INVALID_ADDRESS;
+    if(meta_sector + 2 > slot_sector && meta_sector < slot_sector + W25Q64_SLOTS_COUNT * slot_sectors) return W25Q64_INVALID_ADDRESS;
+    _flash = flash;
+    _meta_sector = meta_sector;
+    _slot_sector = slot_sector;
+    _slot_sectors = slot_sectors;
+    _writing = W25Q64_SLOTS_NONE;
+
+    // find the newest intact metadata record in either sector
+    memset(&_meta, 0, sizeof(_meta));
+    _meta.active = W25Q64_SLOTS_NONE;
+    _meta_slot = 0;
+    _meta_ready = false;
+    bool found = false;
+    W25Q64_Slots_meta_t meta;
+    _flash->waitWhileBusy();
+    for(unsigned int slot = 0; slot < W25Q64_SLOTS_META_SLOTS; slot ++){
+        _flash->fastRead(_meta_sector * W25Q64_SECTOR_SIZE + slot * W25Q64_PAGE_SIZE, (byte*)&meta, sizeof(meta));
+        if(meta.magic != W25Q64_SLOTS_MAGIC) continue;
+        if(meta.crc != W25Q64_crc32((byte*)&meta, sizeof(meta) - sizeof(meta.crc))) continue;
+        if(found && meta.sequence <= _meta.sequence) continue;
+        memcpy(&_meta, &meta, sizeof(meta));
+        _meta_slot = slot + 1;
+        found = true;
+    }
+    // never reuse pages of the current sector past a torn record
+    if(found && _meta_slot % W25Q64_SLOTS_SECTOR_PAGES != 0){
+        byte probe[sizeof(W25Q64_Slots_meta_t)];
+        _flash->fastRead(_meta_sector * W25Q64_SECTOR_SIZE + _meta_slot * W25Q64_PAGE_SIZE, probe, sizeof(probe));
+        _meta_ready = true;
+        for(unsigned int i = 0; i < sizeof(probe); i ++){
+            if(probe[i] != 0xFF) _meta_ready = false;
+        }
+        if(!_meta_ready) _meta_slot = (_meta_slot / W25Q64_SLOTS_SECTOR_PAGES + 1) * W25Q64_SLOTS_SECTOR_PAGES;
+    }
+    _meta_slot %= W25Q64_SLOTS_META_SLOTS;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Slots::begin(unsigned int slot){
+    if(slot >= W25Q64_SLOTS_COUNT || slot == _meta.active) return W25Q64_INVALID_ARGUMENT;
+    _writing = W25Q64_SLOTS_NONE;
+    if(_meta.slot[slot].valid == 1){
+        // invalidate first so a reset mid-write can never leave a half written image marked valid
+        memset(&_meta.slot[slot], 0, sizeof(W25Q64_Slot_info_t));
+        W25Q64_status_t status = _writeMeta();
+        if(status != W25Q64_OK) return status;
+    }
+    _writing = slot;
+    _size = 0;
+    _crc = W25Q64_CRC32_INIT;
+    _fill = 0;
+    memset(_page, 0xFF, W25Q64_PAGE_SIZE);
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Slots::write(const byte* buff, unsigned int len){
+    if(_writing == W25Q64_SLOTS_NONE) return W25Q64_INVALID_ARGUMENT;
+    if(_size + len > _slot_sectors * W25Q64_SECTOR_SIZE) return W25Q64_FULL;
+    while(len > 0){
+        if(_size % W25Q64_SECTOR_SIZE == 0){
+            W25Q64_status_t status = _erase(_slotAddress(_writing, _size));
+            if(status != W25Q64_OK) return status;
+        }
+        unsigned int n = W25Q64_PAGE_SIZE - _fill;
+        if(n > len) n = len;
+        // the crc is taken as the data is staged, no second pass over the image
+        _crc = W25Q64_crc32Copy(_crc, _page + _fill, buff, n);
+        _fill += n;
+        _size += n;
+        buff += n;
+        len -= n;
+        if(_fill == W25Q64_PAGE_SIZE){
+            W25Q64_status_t status = _programPage();
+            if(status != W25Q64_OK) return status;
+        }
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Slots::finish(uint32_t version, uint32_t* crc){
+    if(_writing == W25Q64_SLOTS_NONE) return W25Q64_INVALID_ARGUMENT;
+    if(_fill > 0){
+        W25Q64_status_t status = _programPage();
+        if(status != W25Q64_OK) return status;
+    }
+    W25Q64_Slot_info_t* info = &_meta.slot[_writing];
+    info->valid = 1;
+    info->size = _size;
+    info->crc = ~_crc;
+    info->version = version;
+    _writing = W25Q64_SLOTS_NONE;
+    if(crc != NULL) *crc = info->crc;
+    return _writeMeta();
+}
+
+W25Q64_status_t W25Q64_Slots::activate(unsigned int slot){
+    if(slot >= W25Q64_SLOTS_COUNT || _meta.slot[slot].valid != 1 || slot == _writing) return W25Q64_INVALID_ARGUMENT;
+    if(_meta.active == slot) return W25Q64_OK;
+    _meta.active = slot;
+    return _writeMeta();
+}
+
+W25Q64_status_t W25Q64_Slots::info(unsigned int slot, W25Q64_Slot_info_t* info){
+    if(slot >= W25Q64_SLOTS_COUNT) return W25Q64_INVALID_ARGUMENT;
+    memcpy(info, &_meta.slot[slot], sizeof(W25Q64_Slot_info_t));
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Slots::verify(unsigned int slot){
+    if(slot >= W25Q64_SLOTS_COUNT) return W25Q64_INVALID_ARGUMENT;
+    if(_meta.slot[slot].valid != 1 || slot == _writing) return W25Q64_NOT_FOUND;
+    uint32_t crc = W25Q64_CRC32_INIT;
+    byte buff[W25Q64_PAGE_SIZE];
+    for(unsigned int offset = 0; offset < _meta.slot[slot].size; offset += W25Q64_PAGE_SIZE){
+        unsigned int n = _meta.slot[slot].size - offset;
+        if(n > W25Q64_PAGE_SIZE) n = W25Q64_PAGE_SIZE;
+        W25Q64_status_t status = W25Q64_crc32Read(_flash, _slotAddress(slot, offset), buff, n, &crc);
+        if(status != W25Q64_OK) return status;
+    }
+    if(~crc != _meta.slot[slot].crc) return W25Q64_CORRUPT;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Slots::read(unsigned int slot, unsigned int offset, byte* buff, unsigned int len){
+    if(slot >= W25Q64_SLOTS_COUNT) return W25Q64_INVALID_ARGUMENT;
+    if(offset + len > _slot_sectors * W25Q64_SECTOR_SIZE) return W25Q64_INVALID_ADDRESS;
+    return _flash->fastRead(_slotAddress(slot, offset), buff, len);
+}
+
+W25Q64_status_t W25Q64_Slots::_writeMeta(){
+    W25Q64_status_t status;
+    if(!_meta_ready){
+        // a fresh metadata sector must be erased before its first record, the other sector still holds the last record
+        status = _erase((_meta_sector + _meta_slot / W25Q64_SLOTS_SECTOR_PAGES) * W25Q64_SECTOR_SIZE);
+        if(status != W25Q64_OK) return status;
+        _meta_ready = true;
+    }
+    _meta.magic = W25Q64_SLOTS_MAGIC;
+    _meta.sequence ++;
+    _meta.crc = W25Q64_crc32((byte*)&_meta, sizeof(_meta) - sizeof(_meta.crc));
+    status = _program(_meta_sector * W25Q64_SECTOR_SIZE + _meta_slot * W25Q64_PAGE_SIZE, (byte*)&_meta, sizeof(_meta));
+    if(status != W25Q64_OK) return status;
+    _meta_slot = (_meta_slot + 1) % W25Q64_SLOTS_META_SLOTS;
+    if(_meta_slot % W25Q64_SLOTS_SECTOR_PAGES == 0) _meta_ready = false;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Slots::_programPage(){
+    W25Q64_status_t status = _program(_slotAddress(_writing, (_size - 1) / W25Q64_PAGE_SIZE * W25Q64_PAGE_SIZE), _page, _fill);
+    memset(_page, 0xFF, W25Q64_PAGE_SIZE);
+    _fill = 0;
+    return status;
+}
+
+W25Q64_status_t W25Q64_Slots::_erase(unsigned int addr){
+    _flash->waitWhileBusy();
+    _flash->writeEnable();
+    W25Q64_status_t status = _flash->sectorErase(addr);
+    if(status != W25Q64_OK) return status;
+    return _flash->waitWhileBusy();
+}
+
+W25Q64_status_t W25Q64_Slots::_program(unsigned int addr, byte* buff, unsigned int len){
+    _flash->writeEnable();
+    W25Q64_status_t status = _flash->pageProgram(addr, buff, len);
+    if(status != W25Q64_OK) return status;
+    return _flash->waitWhileBusy();
+}
@@ -0,0 +1,190 @@
+/**
+ * @file W25Q64_Slots.hpp
+ * @author Jeremy Dunne
+ * @brief A/B firmware image slots with streaming CRC32 on the W25Q64
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_SLOTS_HPP_
+#define _W25Q64_SLOTS_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+#include "W25Q64_CRC.hpp"
+
+
+// slot settings
+#define W25Q64_SLOTS_COUNT                  2 // A and B
+#define W25Q64_SLOTS_MAGIC                  0x544F4C53 // "SLOT"
+#define W25Q64_SLOTS_NONE                   0xFFFFFFFF // no active slot
+
+/**
+ * @brief state of one image slot
+ *
+ */
+typedef struct{
+    uint32_t valid;             ///< 1 once the image was completely written
+    uint32_t size;              ///< image bytes
+    uint32_t crc;               ///< CRC32 of the image
+    uint32_t version;           ///< caller supplied image version
+} W25Q64_Slot_info_t;
+
+/**
+ * @brief metadata record, one per change
+ *
+ */
+typedef struct{
+    uint32_t magic;                                 ///< W25Q64_SLOTS_MAGIC
+    uint32_t sequence;                              ///< record sequence, highest valid record wins
+    uint32_t active;                                ///< slot to boot, W25Q64_SLOTS_NONE if none
+    W25Q64_Slot_info_t slot[W25Q64_SLOTS_COUNT];    ///< state of every slot
+    uint32_t crc;                                   ///< CRC32 of everything above
+} W25Q64_Slots_meta_t;
+
+/**
+ * @brief A/B image slot manager
+ *
+ * An incoming image is streamed into the inactive slot with page sized write-combining while its CRC32 is computed on
+ *  the data as it is programmed, so no second pass over the image is needed. Slot state lives in small metadata records
+ *  appended to two ping-pong metadata sectors (the same scheme as W25Q64_Atomic's root records): marking a slot valid or
+ *  swapping the active slot is a single page program, the images are never copied.
+ *
+ */
+class W25Q64_Slots{
+public:
+    /**
+     * @brief initialize and recover the slot state
+     *
+     * @param flash initialized flash chip
+     * @param meta_sector first of the two metadata sectors
+     * @param slot_sector first sector of slot A, slot B follows it
+     * @param slot_sectors sectors per slot
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t init(W25Q64* flash, unsigned int meta_sector, unsigned int slot_sector, unsigned int slot_sectors);
+
+    /**
+     * @brief start writing an image into a slot
+     *
+     * The slot is marked invalid before anything in it is erased
+     *
+     * @param slot slot to write, must not be the active slot
+     * @return W25Q64_status_t W25Q64_INVALID_ARGUMENT for the active slot
+     */
+    W25Q64_status_t begin(unsigned int slot);
+
+    /**
+     * @brief append image data
+     *
+     * @param buff data to append
+     * @param len number of bytes
+     * @return W25Q64_status_t W25Q64_FULL if the image outgrows the slot
+     */
+    W25Q64_status_t write(const byte* buff, unsigned int len);
+
+    /**
+     * @brief program the rest of the image and mark the slot valid
+     *
+     * @param version image version to record
+     * @param crc receives the CRC32 of the image, may be NULL
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t finish(uint32_t version, uint32_t* crc);
+
+    /**
+     * @brief make a valid slot the active one
+     *
+     * @param slot slot to activate
+     * @return W25Q64_status_t W25Q64_INVALID_ARGUMENT if the slot does not hold a valid image
+     */
+    W25Q64_status_t activate(unsigned int slot);
+
+    /**
+     * @brief get the active slot
+     *
+     * @return uint32_t active slot, W25Q64_SLOTS_NONE if none
+     */
+    uint32_t active(){return _meta.active;};
+
+    /**
+     * @brief get the state of a slot
+     *
+     * @param slot slot to look up
+     * @param info receives the slot state
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t info(unsigned int slot, W25Q64_Slot_info_t* info);
+
+    /**
+     * @brief read back a slot and check it against its recorded CRC32
+     *
+     * @param slot slot to check
+     * @return W25Q64_status_t W25Q64_CORRUPT if the image does not match, W25Q64_NOT_FOUND if the slot is not valid
+     */
+    W25Q64_status_t verify(unsigned int slot);
+
+    /**
+     * @brief read from an image
+     *
+     * @param slot slot to read
+     * @param offset byte offset within the image
+     * @param buff buffer to read into
+     * @param len number of bytes
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t read(unsigned int slot, unsigned int offset, byte* buff, unsigned int len);
+
+private:
+    W25Q64* _flash; ///< underlying chip
+    unsigned int _meta_sector; ///< first of the two metadata sectors
+    unsigned int _slot_sector; ///< first sector of slot A
+    unsigned int _slot_sectors; ///< sectors per slot
+    unsigned int _meta_slot; ///< next metadata page to program, counted over both sectors
+    bool _meta_ready; ///< true if the sector holding _meta_slot is erased
+    W25Q64_Slots_meta_t _meta; ///< last metadata record
+    unsigned int _writing; ///< slot being written, W25Q64_SLOTS_NONE if none
+    unsigned int _size; ///< bytes written to the slot
+    uint32_t _crc; ///< running CRC32 of the image
+    unsigned int _fill; ///< bytes staged in _page
+    byte _page[W25Q64_PAGE_SIZE]; ///< page being staged
+
+    /**
+     * @brief get the chip address of a byte in a slot
+     *
+     */
+    unsigned int _slotAddress(unsigned int slot, unsigned int offset){
+        return (_slot_sector + slot * _slot_sectors) * W25Q64_SECTOR_SIZE + offset;
+    };
+
+    /**
+     * @brief append a metadata record built from _meta
+     *
+     */
+    W25Q64_status_t _writeMeta();
+
+    /**
+     * @brief program the staged page
+     *
+     */
+    W25Q64_status_t _programPage();
+
+    /**
+     * @brief erase a sector and wait for it
+     *
+     */
+    W25Q64_status_t _erase(unsigned int addr);
+
+    /**
+     * @brief program up to a page and wait for it
+     *
+     */
+    W25Q64_status_t _program(unsigned int addr, byte* buff, unsigned int len);
+};
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ * @file W25Q64_Stream.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 stream reader
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_Stream.hpp"
+
+W25Q64_status_t W25Q64_Stream::init(W25Q64* flash){
+    _flash = flash;
+    _fills = 0;
+    invalidate();
+    flash->addObserver(this);
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Stream::read(unsigned int addr, byte* buff, unsigned int len){
+    if(addr + len > W25Q64_MAX_ADDRESS + 1) return W25Q64_INVALID_ADDRESS;
+    _sequential = addr == _next;
+    if(!_sequential) _window = W25Q64_STREAM_MIN_WINDOW;
+    _next = addr + len;
+    while(len > 0){
+        unsigned int back = _front ^ 1;
+        if(!_holds(_front, addr)){
+            if(_holds(back, addr)){
+                // the front is used up, the back becomes the front and poll() refills the old one
+                _len[_front] = 0;
+                _front = back;
+            }
+            else{
+                _flash->waitWhileBusy();
+                W25Q64_status_t status = _fill(_front, addr);
+                if(status != W25Q64_OK) return status;
+            }
+        }
+        unsigned int offset = addr - _addr[_front];
+        unsigned int n = _len[_front] - offset;
+        if(n > len) n = len;
+        memcpy(buff, &_buff[_front][offset], n);
+        addr += n;
+        buff += n;
+        len -= n;
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Stream::poll(){
+    unsigned int back = _front ^ 1;
+    if(!_sequential || _len[_front] == 0) return W25Q64_OK;
+    unsigned int addr = _addr[_front] + _len[_front];
+    if(addr > W25Q64_MAX_ADDRESS || _holds(back, addr)) return W25Q64_OK;
+    if(_flash->busy()) return W25Q64_BUSY;
+    return _fill(back, addr);
+}
+
+void W25Q64_Stream::invalidate(){
+    _front = 0;
+    _len[0] = 0;
+    _len[1] = 0;
+    // nothing counts as sequential until the first read
+    _next = W25Q64_MAX_ADDRESS + 1;
+    _window = W25Q64_STREAM_MIN_WINDOW;
+    _sequential = false;
+}
+
+void W25Q64_Stream::mutated(W25Q64_mutation_t, unsigned int addr, const byte*, unsigned int len){
+    for(unsigned int i = 0; i < 2; i ++){
+        if(_len[i] > 0 && addr < _addr[i] + _len[i] && _addr[i] < addr + len) _len[i] = 0;
+    }
+}
+
+W25Q64_status_t W25Q64_Stream::_fill(unsigned int index, unsigned int addr){
+    unsigned int len = _window;
+    if(len > W25Q64_MAX_ADDRESS + 1 - addr) len = W25Q64_MAX_ADDRESS + 1 - addr;
+    _len[index] = 0;
+    W25Q64_status_t status = _flash->fastRead(addr, _buff[index], len);
+    if(status != W25Q64_OK) return status;
+    _addr[index] = addr;
+    _len[index] = len;
+    _fills ++;
+    // every fill of a sequential run earns a bigger window for the next one
+    if(_sequential && _window < W25Q64_STREAM_MAX_WINDOW) _window *= 2;
+    return W25Q64_OK;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file W25Q64_Stream.hpp
+ * @author Jeremy Dunne
+ * @brief Adaptive read-ahead stream reader for the W25Q64
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_STREAM_HPP_
+#define _W25Q64_STREAM_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+
+
+// stream settings
+#define W25Q64_STREAM_MIN_WINDOW            256 // bytes fetched after a jump
+#define W25Q64_STREAM_MAX_WINDOW            2048 // largest window, size of each of the two buffers
+
+/**
+ * @brief reader that turns small sequential reads into large bursts
+ *
+ * Every read() that starts where the last one ended counts as sequential. The first fetch after a jump is
+ *  W25Q64_STREAM_MIN_WINDOW bytes, each further fetch of a sequential run doubles the window up to
+ *  W25Q64_STREAM_MAX_WINDOW, so the opcode, address and dummy byte are paid once per window instead of once per read.
+ *  There are two buffers: the caller consumes the front one while poll(), called whenever the application has time,
+ *  fills the back one with the next window. When the front runs out the buffers swap and a read only waits on the chip if
+ *  the back one was not filled in time. A buffer is dropped when the chip reports a program or erase over its range.
+ *
+ */
+class W25Q64_Stream : public W25Q64_Observer{
+public:
+    /**
+     * @brief set up the reader and start observing the chip
+     *
+     * @param flash initialized flash chip
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t init(W25Q64* flash);
+
+    /**
+     * @brief read data through the buffers
+     *
+     * @param addr address to read from
+     * @param buff buffer to read into
+     * @param len number of bytes
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t read(unsigned int addr, byte* buff, unsigned int len);
+
+    /**
+     * @brief fill the back buffer with the next window of a sequential run
+     *
+     * @return W25Q64_status_t W25Q64_BUSY if the chip is busy and nothing was read
+     */
+    W25Q64_status_t poll();
+
+    /**
+     * @brief drop both buffers
+     *
+     */
+    void invalidate();
+
+    /**
+     * @brief drop the buffers a program or erase overlaps, called by the chip
+     *
+     * @param kind what happened to the range
+     * @param addr start of the range
+     * @param data bytes programmed, NULL for an erase
+     * @param len length of the range
+     */
+    void mutated(W25Q64_mutation_t kind, unsigned int addr, const byte* data, unsigned int len);
+
+    /**
+     * @brief get the current window
+     *
+     * @return unsigned int bytes fetched per burst
+     */
+    unsigned int window(){return _window;};
+
+    /**
+     * @brief get the number of reads from the chip
+     *
+     * @return unsigned long bursts read
+     */
+    unsigned long fills(){return _fills;};
+
+private:
+    W25Q64* _flash; ///< flash chip used
+    byte _buff[2][W25Q64_STREAM_MAX_WINDOW]; ///< front and back buffer
+    unsigned int _front; ///< index of the buffer being consumed
+    unsigned int _addr[2]; ///< chip address each buffer starts at
+    unsigned int _len[2]; ///< bytes held by each buffer, 0 if empty
+    unsigned int _next; ///< address right after the last read
+    unsigned int _window; ///< bytes fetched by the next fill
+    bool _sequential; ///< true while reads follow each other
+    unsigned long _fills; ///< reads from the chip
+
+    /**
+     * @brief fill a buffer with the window starting at addr
+     *
+     */
+    W25Q64_status_t _fill(unsigned int index, unsigned int addr);
+
+    /**
+     * @brief check if a buffer holds addr
+     *
+     */
+    bool _holds(unsigned int index, unsigned int addr){return _len[index] > 0 && addr >= _addr[index] && addr - _addr[index] < _len[index];};
+};
+
+#endif
@@ -0,0 +1,81 @@
+/**
+ * @file W25Q64_Stripe.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 page striping
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_Stripe.hpp"
+
+W25Q64_status_t W25Q64_Stripe::init(W25Q64** chips, unsigned int count){
+    if(count == 0 || count > W25Q64_STRIPE_MAX_CHIPS) return W25Q64_INVALID_ARGUMENT;
+    _count = count;
+    for(unsigned int i = 0; i < count; i ++){
+        _chips[i] = chips[i];
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Stripe::read(unsigned int addr, byte* buff, unsigned int len){
+    if(addr + len > capacity()) return W25Q64_INVALID_ADDRESS;
+    while(len > 0){
+        unsigned int page = addr / W25Q64_PAGE_SIZE;
+        unsigned int offset = addr % W25Q64_PAGE_SIZE;
+        unsigned int n = W25Q64_PAGE_SIZE - offset;
+        if(n > len) n = len;
+        W25Q64* chip = _chip(page);
+        chip->waitWhileBusy();
+        W25Q64_status_t status = chip->fastRead(_chipAddress(page) + offset, buff, n);
+        if(status != W25Q64_OK) return status;
+        addr += n;
+        buff += n;
+        len -= n;
+    }
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_Stripe::write(unsigned int addr, byte* buff, unsigned int len){
+    if(addr + len > capacity()) return W25Q64_INVALID_ADDRESS;
+    while(len > 0){
+        unsigned int page = addr / W25Q64_PAGE_SIZE;
+        unsigned int offset = addr % W25Q64_PAGE_SIZE;
+        unsigned int n = W25Q64_PAGE_SIZE - offset;
+        if(n > len) n = len;
+        // only this page's chip has to be idle, the others keep programming
+        W25Q64* chip = _chip(page);
+        chip->waitWhileBusy();
+        chip->writeEnable();
+        W25Q64_status_t status = chip->pageProgram(_chipAddress(page) + offset, buff, n);
+        if(status != W25Q64_OK) return status;
+        addr += n;
+        buff += n;
+        len -= n;
+    }
+    return waitWhileBusy();
+}
+
+W25Q64_status_t W25Q64_Stripe::erase(unsigned int addr, unsigned int len){
+    if(addr % eraseSize() != 0 || len % eraseSize() != 0) return W25Q64_INVALID_ADDRESS;
+    if(addr + len > capacity()) return W25Q64_INVALID_ADDRESS;
+    for(unsigned int unit = addr / eraseSize(); unit < (addr + len) / eraseSize(); unit ++){
+        // the same sector on every chip, all erasing at once
+        for(unsigned int i = 0; i < _count; i ++){
+            _chips[i]->waitWhileBusy();
+            _chips[i]->writeEnable();
+            W25Q64_status_t status = _chips[i]->sectorErase(unit * W25Q64_SECTOR_SIZE);
+            if(status != W25Q64_OK) return status;
+        }
+    }
+    return waitWhileBusy();
+}
+
+W25Q64_status_t W25Q64_Stripe::waitWhileBusy(){
+    for(unsigned int i = 0; i < _count; i ++){
+        _chips[i]->waitWhileBusy();
+    }
+    return W25Q64_OK;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file W25Q64_Stripe.hpp
+ * @author Jeremy Dunne
+ * @brief RAID-0 style page striping across several W25Q64 chips
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_STRIPE_HPP_
+#define _W25Q64_STRIPE_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+
+
+// stripe settings
+#define W25Q64_STRIPE_MAX_CHIPS             4 // max chips in a stripe set
+
+/**
+ * @brief several chips acting as one device with pages interleaved across them
+ *
+ * Logical page p lives on chip p % n at page p / n, so consecutive pages go to different chips. A write starts the page
+ *  program on one chip and moves on to the next without waiting, only waiting when it comes back round to a chip that is
+ *  still busy; with n chips n programs overlap and the SPI transfer of one page hides behind tPP of the others. An erase
+ *  unit is the same sector on every chip (n * 4 KB) and all of those erases run at once.
+ *
+ */
+class W25Q64_Stripe{
+public:
+    /**
+     * @brief set up the stripe set
+     *
+     * @param chips initialized chips, each on its own chip select
+     * @param count number of chips, at most W25Q64_STRIPE_MAX_CHIPS
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t init(W25Q64** chips, unsigned int count);
+
+    /**
+     * @brief read from the device
+     *
+     * @param addr logical address
+     * @param buff buffer to read into
+     * @param len number of bytes
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t read(unsigned int addr, byte* buff, unsigned int len);
+
+    /**
+     * @brief program erased memory, any length and alignment
+     *
+     * Returns once every program has finished
+     *
+     * @param addr logical address
+     * @param buff data to program
+     * @param len number of bytes
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t write(unsigned int addr, byte* buff, unsigned int len);
+
+    /**
+     * @brief erase whole erase units
+     *
+     * @param addr logical address, a multiple of eraseSize()
+     * @param len number of bytes, a multiple of eraseSize()
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t erase(unsigned int addr, unsigned int len);
+
+    /**
+     * @brief wait for every chip to finish
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t waitWhileBusy();
+
+    /**
+     * @brief get the size of the device
+     *
+     * @return unsigned long bytes
+     */
+    unsigned long capacity(){return (unsigned long)_count * (W25Q64_MAX_ADDRESS + 1);};
+
+    /**
+     * @brief get the erase unit of the device
+     *
+     * @return unsigned int bytes
+     */
+    unsigned int eraseSize(){return _count * W25Q64_SECTOR_SIZE;};
+
+private:
+    W25Q64* _chips[W25Q64_STRIPE_MAX_CHIPS]; ///< member chips
+    unsigned int _count; ///< chips in the set
+
+    /**
+     * @brief get the chip holding a logical page
+     *
+     */
+    W25Q64* _chip(unsigned int page){
+        return _chips[page % _count];
+    };
+
+    /**
+     * @brief get the chip address of a logical page
+     *
+     */
+    unsigned int _chipAddress(unsigned int page){
+        return (page / _count) * W25Q64_PAGE_SIZE;
+    };
+};
+
+#endif
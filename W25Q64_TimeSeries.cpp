@@ -0,0 +1,358 @@
+/**
+ * @file W25Q64_TimeSeries.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 time-series log
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_TimeSeries.hpp"
+
+#define W25Q64_TS_SECTOR_PAGES              (W25Q64_SECTOR_SIZE / W25Q64_PAGE_SIZE)
+
+W25Q64_status_t W25Q64_TimeSeries::init(W25Q64* flash, unsigned int first_sector, unsigned int sector_count, unsigned int record_size){
+    if(sector_count < 2 || sector_count > W25Q64_TS_MAX_SECTORS) return W25Q64_INVALID_ADDRESS;
+    if(first_sector + sector_count > W25Q64_SECTOR_COUNT) return W25Q64_INVALID_ADDRESS;
+    if(record_size == 0 || record_size + sizeof(uint32_t) > W25Q64_PAGE_SIZE - W25Q64_TS_HEADER_SIZE) return W25Q64_INVALID_ARGUMENT;
+    _flash = flash;
+    _first_sector = first_sector;
+    _sector_count = sector_count;
+    _record_size = record_size + sizeof(uint32_t);
+    _oldest = 0;
+    _used = 0;
+    _sequence = 0;
+    _page = 0;
+    _fill = 0;
+    _programmed = 0;
+    _last = 0;
+    _flash->waitWhileBusy();
+
+    // the newest sector is the one with the highest sequence
+    W25Q64_TS_header_t header;
+    bool found = false;
+    unsigned int newest = 0;
+    for(unsigned int sector = 0; sector < _sector_count; sector ++){
+        _flash->fastRead(_pageAddress(sector, 0), (byte*)&header, sizeof(header));
+        if(header.magic != W25Q64_TS_MAGIC) continue;
+        if(!found || header.sequence > _sequence){
+            _sequence = header.sequence;
+            newest = sector;
+            found = true;
+        }
+    }
+    if(!found) return W25Q64_OK;
+
+    // walk back over the run of consecutive sequences to the oldest sector
+    _used = 1;
+    _oldest = newest;
+    while(_used < _sector_count){
+        unsigned int previous = (_oldest + _sector_count - 1) % _sector_count;
+        _flash->fastRead(_pageAddress(previous, 0), (byte*)&header, sizeof(header));
+        if(header.magic != W25Q64_TS_MAGIC || header.sequence != _sequence - _used) break;
+        _oldest = previous;
+        _used ++;
+    }
+
+    // find where the newest sector ends
+    if(!_scan(newest, &_page, &_fill, &_last)){
+        _page = 0;
+        _fill = W25Q64_TS_HEADER_SIZE;
+        _flash->fastRead(_pageAddress(newest, 0), (byte*)&header, sizeof(header));
+        _last = header.first_timestamp;
+    }
+    _programmed = _fill;
+    if(_page < W25Q64_TS_SECTOR_PAGES){
+        _flash->fastRead(_pageAddress(newest, _page), _image, W25Q64_PAGE_SIZE);
+    }
+
+#if W25Q64_TS_RAM_INDEX
+    for(unsigned int position = 0; position < _used; position ++){
+        unsigned int sector = (_oldest + position) % _sector_count;
+        _flash->fastRead(_pageAddress(sector, 0), (byte*)&header, sizeof(header));
+        _first_index[sector] = header.first_timestamp;
+        _last_index[sector] = header.last_timestamp;
+        unsigned int page, fill;
+        if(sector == newest) _last_index[sector] = _last;
+        else if(header.last_timestamp == W25Q64_TS_BLANK && !_scan(sector, &page, &fill, &_last_index[sector])){
+            _last_index[sector] = header.first_timestamp;
+        }
+    }
+#endif
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_TimeSeries::clear(){
+    for(unsigned int position = 0; position < _used; position ++){
+        W25Q64_status_t status = _erase((_oldest + position) % _sector_count);
+        if(status != W25Q64_OK) return status;
+    }
+    _oldest = (_oldest + _used) % _sector_count;
+    _used = 0;
+    _page = 0;
+    _fill = 0;
+    _programmed = 0;
+    _last = 0;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_TimeSeries::append(uint32_t timestamp, byte* record){
+    if(timestamp == W25Q64_TS_BLANK) return W25Q64_INVALID_ARGUMENT;
+    if(_used > 0 && timestamp < _last) return W25Q64_INVALID_ARGUMENT;
+    W25Q64_status_t status;
+    if(_used == 0 || _page >= W25Q64_TS_SECTOR_PAGES){
+        status = _open(timestamp);
+        if(status != W25Q64_OK) return status;
+    }
+    else if(_fill + _record_size > W25Q64_PAGE_SIZE){
+        // page is full, move on to the next one
+        status = flush();
+        if(status != W25Q64_OK) return status;
+        _page ++;
+        if(_page >= W25Q64_TS_SECTOR_PAGES){
+            status = _open(timestamp);
+            if(status != W25Q64_OK) return status;
+        }
+        else{
+            memset(_image, 0xFF, W25Q64_PAGE_SIZE);
+            _fill = 0;
+            _programmed = 0;
+        }
+    }
+    memcpy(_image + _fill, &timestamp, sizeof(timestamp));
+    memcpy(_image + _fill + sizeof(timestamp), record, _record_size - sizeof(timestamp));
+    _fill += _record_size;
+    _last = timestamp;
+#if W25Q64_TS_RAM_INDEX
+    _last_index[(_oldest + _used - 1) % _sector_count] = timestamp;
+#endif
+    // program whole pages, partial pages wait for more records or flush()
+    if(_fill + _record_size > W25Q64_PAGE_SIZE) return flush();
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_TimeSeries::flush(){
+    if(_used == 0 || _programmed >= _fill) return W25Q64_OK;
+    unsigned int sector = (_oldest + _used - 1) % _sector_count;
+    W25Q64_status_t status = _program(_pageAddress(sector, _page) + _programmed, _image + _programmed, _fill - _programmed);
+    if(status != W25Q64_OK) return status;
+    _programmed = _fill;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_TimeSeries::query(uint32_t start, uint32_t end, W25Q64_TS_cursor_t* cursor){
+    cursor->start = start;
+    cursor->end = end;
+    cursor->page = 0;
+    cursor->slot = 0;
+    cursor->loaded = false;
+    cursor->done = _used == 0 || start > end;
+    if(cursor->done) return W25Q64_OK;
+
+    // binary search for the first sector that ends at or after start
+    unsigned int low = 0, high = _used;
+    uint32_t first, last;
+    while(low < high){
+        unsigned int mid = (low + high) / 2;
+        _bounds(mid, &first, &last);
+        if(last < start) low = mid + 1;
+        else high = mid;
+    }
+    cursor->position = low;
+    if(low >= _used){
+        cursor->done = true;
+        return W25Q64_OK;
+    }
+    _bounds(low, &first, &last);
+    if(first > end){
+        cursor->done = true;
+        return W25Q64_OK;
+    }
+
+    // then for the last page starting at or before start, so earlier pages are never read
+    unsigned int sector = (_oldest + low) % _sector_count;
+    unsigned int newest = (_oldest + _used - 1) % _sector_count;
+    low = 0;
+    high = W25Q64_TS_SECTOR_PAGES - 1;
+    if(sector == newest && _page < high) high = _page;
+    while(low < high){
+        unsigned int mid = (low + high + 1) / 2;
+        uint32_t timestamp;
+        if(sector == newest && mid == _page) memcpy(&timestamp, _image + _pageStart(mid), sizeof(timestamp));
+        else _flash->fastRead(_pageAddress(sector, mid) + _pageStart(mid), (byte*)&timestamp, sizeof(timestamp));
+        if(timestamp != W25Q64_TS_BLANK && timestamp < start) low = mid;
+        else high = mid - 1;
+    }
+    cursor->page = low;
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_TimeSeries::next(W25Q64_TS_cursor_t* cursor, uint32_t* timestamp, byte* record){
+    while(!cursor->done){
+        if(cursor->position >= _used){
+            cursor->done = true;
+            break;
+        }
+        unsigned int sector = (_oldest + cursor->position) % _sector_count;
+        bool newest = cursor->position == _used - 1;
+        if(cursor->page >= W25Q64_TS_SECTOR_PAGES){
+            cursor->position ++;
+            cursor->page = 0;
+            cursor->slot = 0;
+            cursor->loaded = false;
+            continue;
+        }
+        if(!cursor->loaded){
+            // the page being filled is served from RAM, it may not be programmed yet
+            if(newest && cursor->page == _page){
+                memcpy(cursor->buff, _image, W25Q64_PAGE_SIZE);
+            }
+            else{
+                W25Q64_status_t status = _flash->fastRead(_pageAddress(sector, cursor->page), cursor->buff, W25Q64_PAGE_SIZE);
+                if(status != W25Q64_OK) return status;
+            }
+            cursor->loaded = true;
+        }
+        if(cursor->slot >= _slots(cursor->page)){
+            cursor->page ++;
+            cursor->slot = 0;
+            cursor->loaded = false;
+            continue;
+        }
+        byte* entry = cursor->buff + _pageStart(cursor->page) + cursor->slot * _record_size;
+        uint32_t time;
+        memcpy(&time, entry, sizeof(time));
+        if(time == W25Q64_TS_BLANK){
+            // end of the log, or the unused tail of a sealed sector
+            if(newest) cursor->done = true;
+            else cursor->page = W25Q64_TS_SECTOR_PAGES;
+            continue;
+        }
+        cursor->slot ++;
+        if(time < cursor->start) continue;
+        if(time > cursor->end){
+            cursor->done = true;
+            break;
+        }
+        *timestamp = time;
+        memcpy(record, entry + sizeof(time), _record_size - sizeof(time));
+        return W25Q64_OK;
+    }
+    return W25Q64_NOT_FOUND;
+}
+
+W25Q64_status_t W25Q64_TimeSeries::bounds(uint32_t* first, uint32_t* last){
+    if(_used == 0) return W25Q64_NOT_FOUND;
+    uint32_t ignored;
+    _bounds(0, first, &ignored);
+    *last = _last;
+    return W25Q64_OK;
+}
+
+void W25Q64_TimeSeries::_bounds(unsigned int position, uint32_t* first, uint32_t* last){
+    unsigned int sector = (_oldest + position) % _sector_count;
+#if W25Q64_TS_RAM_INDEX
+    *first = _first_index[sector];
+    *last = _last_index[sector];
+#else
+    W25Q64_TS_header_t header;
+    _flash->fastRead(_pageAddress(sector, 0), (byte*)&header, sizeof(header));
+    *first = header.first_timestamp;
+    *last = header.last_timestamp;
+    if(position == _used - 1){
+        *last = _last;
+    }
+    else if(header.last_timestamp == W25Q64_TS_BLANK){
+        // sealing was interrupted
+        unsigned int page, fill;
+        if(!_scan(sector, &page, &fill, last)) *last = header.first_timestamp;
+    }
+#endif
+}
+
+bool W25Q64_TimeSeries::_scan(unsigned int sector, unsigned int* page, unsigned int* fill, uint32_t* last){
+    // records fill the sector in order, so the written slots form a prefix
+    unsigned int first_slots = _slots(0);
+    unsigned int slots = first_slots + (W25Q64_TS_SECTOR_PAGES - 1) * _slots(1);
+    unsigned int low = 0, high = slots;
+    uint32_t timestamp;
+    while(low < high){
+        unsigned int mid = (low + high) / 2;
+        unsigned int p = mid < first_slots ? 0 : 1 + (mid - first_slots) / _slots(1);
+        unsigned int s = mid < first_slots ? mid : (mid - first_slots) % _slots(1);
+        _flash->fastRead(_pageAddress(sector, p) + _pageStart(p) + s * _record_size, (byte*)&timestamp, sizeof(timestamp));
+        if(timestamp != W25Q64_TS_BLANK) low = mid + 1;
+        else high = mid;
+    }
+    if(low == 0) return false;
+    // low is the first blank slot
+    unsigned int k = low - 1;
+    unsigned int p = k < first_slots ? 0 : 1 + (k - first_slots) / _slots(1);
+    unsigned int s = k < first_slots ? k : (k - first_slots) % _slots(1);
+    _flash->fastRead(_pageAddress(sector, p) + _pageStart(p) + s * _record_size, (byte*)last, sizeof(uint32_t));
+    if(low >= slots){
+        *page = W25Q64_TS_SECTOR_PAGES;
+        *fill = 0;
+    }
+    else{
+        *page = low < first_slots ? 0 : 1 + (low - first_slots) / _slots(1);
+        unsigned int slot = low < first_slots ? low : (low - first_slots) % _slots(1);
+        *fill = _pageStart(*page) + slot * _record_size;
+    }
+    return true;
+}
+
+W25Q64_status_t W25Q64_TimeSeries::_open(uint32_t timestamp){
+    W25Q64_status_t status = flush();
+    if(status != W25Q64_OK) return status;
+    unsigned int sector;
+    if(_used > 0){
+        // seal the newest sector
+        sector = (_oldest + _used - 1) % _sector_count;
+        status = _program(_pageAddress(sector, 0) + 3 * sizeof(uint32_t), (byte*)&_last, sizeof(_last));
+        if(status != W25Q64_OK) return status;
+    }
+    if(_used >= _sector_count){
+        // ring is full, the oldest sector is reused
+        _oldest = (_oldest + 1) % _sector_count;
+        _used --;
+    }
+    sector = (_oldest + _used) % _sector_count;
+    status = _erase(sector);
+    if(status != W25Q64_OK) return status;
+    W25Q64_TS_header_t header;
+    header.magic = W25Q64_TS_MAGIC;
+    header.sequence = ++ _sequence;
+    header.first_timestamp = timestamp;
+    header.last_timestamp = W25Q64_TS_BLANK;
+    status = _program(_pageAddress(sector, 0), (byte*)&header, sizeof(header));
+    if(status != W25Q64_OK) return status;
+    _used ++;
+    _page = 0;
+    memset(_image, 0xFF, W25Q64_PAGE_SIZE);
+    memcpy(_image, &header, sizeof(header));
+    _fill = W25Q64_TS_HEADER_SIZE;
+    _programmed = W25Q64_TS_HEADER_SIZE;
+#if W25Q64_TS_RAM_INDEX
+    _first_index[sector] = timestamp;
+    _last_index[sector] = timestamp;
+#endif
+    return W25Q64_OK;
+}
+
+W25Q64_status_t W25Q64_TimeSeries::_erase(unsigned int sector){
+    _flash->waitWhileBusy();
+    _flash->writeEnable();
+    W25Q64_status_t status = _flash->sectorErase(_pageAddress(sector, 0));
+    if(status != W25Q64_OK) return status;
+    return _flash->waitWhileBusy();
+}
+
+W25Q64_status_t W25Q64_TimeSeries::_program(unsigned int addr, byte* buff, unsigned int len){
+    _flash->writeEnable();
+    W25Q64_status_t status = _flash->pageProgram(addr, buff, len);
+    if(status != W25Q64_OK) return status;
+    return _flash->waitWhileBusy();
+}
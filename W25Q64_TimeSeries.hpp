@@ -0,0 +1,208 @@
+/**
+ * @file W25Q64_TimeSeries.hpp
+ * @author Jeremy Dunne
+ * @brief Time-series log with per-sector time bounds for range queries on the W25Q64
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_TIMESERIES_HPP_
+#define _W25Q64_TIMESERIES_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+
+
+// time-series settings
+#define W25Q64_TS_MAX_SECTORS               256 // max sectors in the log
+#ifndef W25Q64_TS_RAM_INDEX
+#define W25Q64_TS_RAM_INDEX                 1 // keep the per-sector time bounds in RAM (8 bytes per sector), 0 reads them from the sector headers
+#endif
+#define W25Q64_TS_MAGIC                     0x53455254 // "TRES"
+#define W25Q64_TS_HEADER_SIZE               16 // bytes reserved at the start of every sector
+#define W25Q64_TS_BLANK                     0xFFFFFFFF // timestamp of an unwritten record slot
+
+/**
+ * @brief header at the start of every sector in the log
+ *
+ * first_timestamp is programmed when the sector is opened, last_timestamp when it is sealed
+ *
+ */
+typedef struct{
+    uint32_t magic;             ///< W25Q64_TS_MAGIC
+    uint32_t sequence;          ///< order the sectors were opened in
+    uint32_t first_timestamp;   ///< timestamp of the first record
+    uint32_t last_timestamp;    ///< timestamp of the last record, blank while the sector is open
+} W25Q64_TS_header_t;
+
+/**
+ * @brief position of a range query
+ *
+ */
+typedef struct{
+    uint32_t start;             ///< first timestamp to return
+    uint32_t end;               ///< last timestamp to return
+    unsigned int position;      ///< sectors from the oldest
+    unsigned int page;          ///< page within the sector
+    unsigned int slot;          ///< record within the page
+    bool loaded;                ///< true if buff holds the current page
+    bool done;                  ///< true once the query has run past end
+    byte buff[W25Q64_PAGE_SIZE]; ///< current page
+} W25Q64_TS_cursor_t;
+
+/**
+ * @brief append-only time-series log
+ *
+ * Stores fixed size records, each tagged with a non-decreasing 32-bit timestamp, in a ring of sectors. Every sector header
+ *  carries the first and last timestamp it holds, so a range query binary-searches the sectors and then streams only the
+ *  pages holding matching records with fastRead(). Records are combined into whole page programs in RAM; the oldest
+ *  sector is erased once the ring is full.
+ *
+ */
+class W25Q64_TimeSeries{
+public:
+    /**
+     * @brief initialize the log and recover its contents
+     *
+     * @param flash initialized flash chip
+     * @param first_sector first sector of the log
+     * @param sector_count number of sectors, at most W25Q64_TS_MAX_SECTORS
+     * @param record_size payload bytes per record, at most a page less the timestamp
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t init(W25Q64* flash, unsigned int first_sector, unsigned int sector_count, unsigned int record_size);
+
+    /**
+     * @brief erase the log
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t clear();
+
+    /**
+     * @brief append a record
+     *
+     * The record is staged in RAM and programmed once its page is full or on flush()
+     *
+     * @param timestamp record time, not older than the previous record and never W25Q64_TS_BLANK
+     * @param record payload of record_size bytes
+     * @return W25Q64_status_t W25Q64_INVALID_ARGUMENT if the timestamp goes backwards
+     */
+    W25Q64_status_t append(uint32_t timestamp, byte* record);
+
+    /**
+     * @brief program the records staged in RAM
+     *
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t flush();
+
+    /**
+     * @brief start a range query
+     *
+     * @param start first timestamp to return
+     * @param end last timestamp to return
+     * @param cursor cursor to set up
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t query(uint32_t start, uint32_t end, W25Q64_TS_cursor_t* cursor);
+
+    /**
+     * @brief get the next record of a range query
+     *
+     * @param cursor cursor set up by query
+     * @param timestamp record time
+     * @param record buffer of record_size bytes
+     * @return W25Q64_status_t W25Q64_NOT_FOUND once there are no more records in the range
+     */
+    W25Q64_status_t next(W25Q64_TS_cursor_t* cursor, uint32_t* timestamp, byte* record);
+
+    /**
+     * @brief get the oldest and newest timestamps in the log
+     *
+     * @param first oldest timestamp
+     * @param last newest timestamp
+     * @return W25Q64_status_t W25Q64_NOT_FOUND if the log is empty
+     */
+    W25Q64_status_t bounds(uint32_t* first, uint32_t* last);
+
+private:
+    W25Q64* _flash; ///< underlying chip
+    unsigned int _first_sector; ///< first sector of the log
+    unsigned int _sector_count; ///< sectors in the ring
+    unsigned int _record_size; ///< stored bytes per record, timestamp included
+    unsigned int _oldest; ///< ring index of the oldest sector
+    unsigned int _used; ///< sectors holding records
+    uint32_t _sequence; ///< sequence of the newest sector
+    unsigned int _page; ///< page being filled in the newest sector
+    unsigned int _fill; ///< bytes of the page image in use
+    unsigned int _programmed; ///< bytes of the page image already on the chip
+    uint32_t _last; ///< newest timestamp
+    byte _image[W25Q64_PAGE_SIZE]; ///< page being filled
+#if W25Q64_TS_RAM_INDEX
+    uint32_t _first_index[W25Q64_TS_MAX_SECTORS]; ///< first timestamp per ring index
+    uint32_t _last_index[W25Q64_TS_MAX_SECTORS]; ///< last timestamp per ring index
+#endif
+
+    /**
+     * @brief get the chip address of a page in a ring sector
+     *
+     */
+    unsigned int _pageAddress(unsigned int sector, unsigned int page){
+        return (_first_sector + sector) * W25Q64_SECTOR_SIZE + page * W25Q64_PAGE_SIZE;
+    };
+
+    /**
+     * @brief get the offset of the first record in a page
+     *
+     */
+    unsigned int _pageStart(unsigned int page){
+        return page == 0 ? W25Q64_TS_HEADER_SIZE : 0;
+    };
+
+    /**
+     * @brief get the records per page
+     *
+     */
+    unsigned int _slots(unsigned int page){
+        return (W25Q64_PAGE_SIZE - _pageStart(page)) / _record_size;
+    };
+
+    /**
+     * @brief get the time bounds of a sector, positions count from the oldest sector
+     *
+     */
+    void _bounds(unsigned int position, uint32_t* first, uint32_t* last);
+
+    /**
+     * @brief find the last record of a sector by binary search over its slots
+     *
+     * @return bool false if the sector holds no records
+     */
+    bool _scan(unsigned int sector, unsigned int* page, unsigned int* fill, uint32_t* last);
+
+    /**
+     * @brief seal the newest sector and open the next one, dropping the oldest if the ring is full
+     *
+     */
+    W25Q64_status_t _open(uint32_t timestamp);
+
+    /**
+     * @brief erase a sector and wait for it
+     *
+     */
+    W25Q64_status_t _erase(unsigned int sector);
+
+    /**
+     * @brief program up to a page and wait for it
+     *
+     */
+    W25Q64_status_t _program(unsigned int addr, byte* buff, unsigned int len);
+};
+
+#endif
@@ -0,0 +1,141 @@
+/**
+ * @file W25Q64_View.cpp
+ * @author Jeremy Dunne
+ * @brief Implementation of the W25Q64 cached view
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "W25Q64_View.hpp"
+
+#define W25Q64_VIEW_LAST_PAGE               (W25Q64_MAX_ADDRESS / W25Q64_PAGE_SIZE)
+
+byte W25Q64_ViewIterator::operator*(){
+    return (*_view)[_index];
+}
+
+W25Q64_status_t W25Q64_View::init(W25Q64* flash, unsigned int addr, unsigned int len){
+    if(addr + len > W25Q64_MAX_ADDRESS + 1) return W25Q64_INVALID_ADDRESS;
+    _flash = flash;
+    _start = addr;
+    _len = len;
+    _hits = 0;
+    _misses = 0;
+    for(unsigned int s = 0; s < W25Q64_VIEW_SETS; s ++){
+        for(unsigned int w = 0; w < W25Q64_VIEW_WAYS; w ++){
+            _lines[s][w].data = _data[w * W25Q64_VIEW_SETS + s];
+        }
+    }
+    invalidate();
+    flash->addObserver(this);
+    return W25Q64_OK;
+}
+
+byte W25Q64_View::operator[](unsigned int offset){
+    if(offset >= _len) return 0xFF;
+    unsigned int addr = _start + offset;
+    W25Q64_View_line_t* line = _line(addr / W25Q64_PAGE_SIZE);
+    if(line == NULL) return 0xFF;
+    return line->data[addr % W25Q64_PAGE_SIZE];
+}
+
+W25Q64_status_t W25Q64_View::read(unsigned int offset, byte* buff, unsigned int len){
+    if(offset > _len || len > _len - offset) return W25Q64_INVALID_ADDRESS;
+    unsigned int addr = _start + offset;
+    while(len > 0){
+        unsigned int n = W25Q64_PAGE_SIZE - addr % W25Q64_PAGE_SIZE;
+        if(n > len) n = len;
+        W25Q64_View_line_t* line = _line(addr / W25Q64_PAGE_SIZE);
+        if(line == NULL) return W25Q64_INVALID_ADDRESS;
+        memcpy(buff, &line->data[addr % W25Q64_PAGE_SIZE], n);
+        addr += n;
+        buff += n;
+        len -= n;
+    }
+    return W25Q64_OK;
+}
+
+void W25Q64_View::invalidate(){
+    for(unsigned int s = 0; s < W25Q64_VIEW_SETS; s ++){
+        for(unsigned int w = 0; w < W25Q64_VIEW_WAYS; w ++){
+            _lines[s][w].valid = false;
+            _lines[s][w].used = 0;
+        }
+    }
+    _clock = 0;
+    // no page is "just before" the first miss
+    _last_fetched = W25Q64_VIEW_LAST_PAGE + 1;
+}
+
+void W25Q64_View::mutated(W25Q64_mutation_t kind, unsigned int addr, const byte* data, unsigned int len){
+    for(unsigned int s = 0; s < W25Q64_VIEW_SETS; s ++){
+        for(unsigned int w = 0; w < W25Q64_VIEW_WAYS; w ++){
+            W25Q64_View_line_t* line = &_lines[s][w];
+            unsigned int page_addr = line->page * W25Q64_PAGE_SIZE;
+            if(!line->valid || page_addr + W25Q64_PAGE_SIZE <= addr || page_addr >= addr + len) continue;
+            unsigned int start = page_addr > addr ? page_addr : addr;
+            unsigned int end = page_addr + W25Q64_PAGE_SIZE < addr + len ? page_addr + W25Q64_PAGE_SIZE : addr + len;
+            // follow the chip: a program only clears bits, an erase sets them all
+            for(unsigned int a = start; a < end; a ++){
+                if(kind == W25Q64_MUTATION_PROGRAM) line->data[a - page_addr] &= data[a - addr];
+                else line->data[a - page_addr] = 0xFF;
+            }
+        }
+    }
+}
+
+W25Q64_View_line_t* W25Q64_View::_line(unsigned int page){
+    W25Q64_View_line_t* set = _lines[page % W25Q64_VIEW_SETS];
+    _clock ++;
+    for(unsigned int w = 0; w < W25Q64_VIEW_WAYS; w ++){
+        if(set[w].valid && set[w].page == page){
+            set[w].used = _clock;
+            _hits ++;
+            return &set[w];
+        }
+    }
+    _misses ++;
+    unsigned int count = 1;
+    if(page == _last_fetched + 1){
+        // a linear walk, bring in the next pages with the same read rather than miss on each of them
+        unsigned int last = (_start + _len - 1) / W25Q64_PAGE_SIZE;
+        while(count <= W25Q64_VIEW_READAHEAD && page + count <= last && !_cached(page + count)) count ++;
+    }
+    return _fetch(page, count);
+}
+
+bool W25Q64_View::_cached(unsigned int page){
+    W25Q64_View_line_t* set = _lines[page % W25Q64_VIEW_SETS];
+    for(unsigned int w = 0; w < W25Q64_VIEW_WAYS; w ++){
+        if(set[w].valid && set[w].page == page) return true;
+    }
+    return false;
+}
+
+W25Q64_View_line_t* W25Q64_View::_fetch(unsigned int page, unsigned int count){
+    W25Q64_View_line_t* set = _lines[page % W25Q64_VIEW_SETS];
+    // an empty way if there is one, the least recently used otherwise
+    unsigned int way = 0;
+    for(unsigned int w = 0; w < W25Q64_VIEW_WAYS && set[way].valid; w ++){
+        if(!set[w].valid || set[w].used < set[way].used) way = w;
+    }
+    // page + i goes to the row i after the first, which is in the set of page + i, the run stops at the last row
+    unsigned int row = way * W25Q64_VIEW_SETS + page % W25Q64_VIEW_SETS;
+    if(count > W25Q64_VIEW_WAYS * W25Q64_VIEW_SETS - row) count = W25Q64_VIEW_WAYS * W25Q64_VIEW_SETS - row;
+    for(unsigned int i = 0; i < count; i ++){
+        _lines[(page + i) % W25Q64_VIEW_SETS][(row + i) / W25Q64_VIEW_SETS].valid = false;
+    }
+    _flash->waitWhileBusy();
+    if(_flash->fastRead(page * W25Q64_PAGE_SIZE, _data[row], count * W25Q64_PAGE_SIZE) != W25Q64_OK) return NULL;
+    for(unsigned int i = 0; i < count; i ++){
+        W25Q64_View_line_t* line = &_lines[(page + i) % W25Q64_VIEW_SETS][(row + i) / W25Q64_VIEW_SETS];
+        line->page = page + i;
+        line->valid = true;
+        line->used = _clock;
+    }
+    _last_fetched = page + count - 1;
+    return &set[way];
+}
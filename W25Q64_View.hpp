@@ -0,0 +1,192 @@
+/**
+ * @file W25Q64_View.hpp
+ * @author Jeremy Dunne
+ * @brief Random access view over W25Q64 memory backed by a page cache
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+
+#ifndef _W25Q64_VIEW_HPP_
+#define _W25Q64_VIEW_HPP_
+
+
+// imports
+#include "W25Q64.hpp"
+
+
+// view settings
+#define W25Q64_VIEW_SETS                    4 // cache sets, a page maps to set page % sets
+#define W25Q64_VIEW_WAYS                    2 // cached pages per set
+#define W25Q64_VIEW_READAHEAD               2 // pages fetched past a sequential miss, less than the number of sets
+
+/**
+ * @brief cached page
+ *
+ */
+typedef struct{
+    unsigned int page;          ///< chip page held
+    bool valid;                 ///< true if data holds the page
+    unsigned long used;         ///< access count of the last use, for LRU
+    byte* data;                 ///< page contents, a row of the view's page buffer
+} W25Q64_View_line_t;
+
+class W25Q64_View;
+
+/**
+ * @brief forward iterator over the bytes of a view
+ *
+ */
+class W25Q64_ViewIterator{
+public:
+    W25Q64_ViewIterator(W25Q64_View* view, unsigned int index) : _view(view), _index(index){};
+    byte operator*();
+    W25Q64_ViewIterator& operator++(){_index ++; return *this;};
+    bool operator==(const W25Q64_ViewIterator& other) const {return _index == other._index;};
+    bool operator!=(const W25Q64_ViewIterator& other) const {return _index != other._index;};
+
+private:
+    W25Q64_View* _view; ///< view iterated
+    unsigned int _index; ///< offset into the view
+};
+
+/**
+ * @brief read-only window onto a range of the chip that can be walked like memory
+ *
+ * Accesses go through a small set-associative cache of whole pages filled with fastRead(). When a miss lands on the page
+ *  right after the previous miss the access is taken to be sequential and the following W25Q64_VIEW_READAHEAD pages are
+ *  fetched with it in the same command, so a linear walk misses once every few pages and costs about the same as reading
+ *  the range in bursts.
+ *  The view observes the chip, programs and erases sent to it are applied to the cached pages.
+ *
+ */
+class W25Q64_View : public W25Q64_Observer{
+public:
+    /**
+     * @brief set up the view and start observing the chip
+     *
+     * @param flash initialized flash chip
+     * @param addr chip address of offset 0
+     * @param len length of the view
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t init(W25Q64* flash, unsigned int addr, unsigned int len);
+
+    /**
+     * @brief read a byte
+     *
+     * @param offset offset into the view
+     * @return byte value, 0xFF past the end of the view
+     */
+    byte operator[](unsigned int offset);
+
+    /**
+     * @brief read a value stored in the chip's byte order
+     *
+     * @param offset offset into the view
+     * @return T value, all 0xFF bytes past the end of the view
+     */
+    template<typename T> T load(unsigned int offset){
+        T value;
+        if(read(offset, (byte*)&value, sizeof(T)) != W25Q64_OK) memset(&value, 0xFF, sizeof(T));
+        return value;
+    };
+
+    /**
+     * @brief copy a range out through the cache
+     *
+     * @param offset offset into the view
+     * @param buff buffer to copy into
+     * @param len number of bytes
+     * @return W25Q64_status_t standard return type
+     */
+    W25Q64_status_t read(unsigned int offset, byte* buff, unsigned int len);
+
+    /**
+     * @brief drop every cached page
+     *
+     */
+    void invalidate();
+
+    /**
+     * @brief apply a program or erase to the cached pages, called by the chip
+     *
+     * @param kind what happened to the range
+     * @param addr start of the range
+     * @param data bytes programmed, NULL for an erase
+     * @param len length of the range
+     */
+    void mutated(W25Q64_mutation_t kind, unsigned int addr, const byte* data, unsigned int len);
+
+    /**
+     * @brief get an iterator to the first byte
+     *
+     * @return W25Q64_ViewIterator iterator at offset 0
+     */
+    W25Q64_ViewIterator begin(){return W25Q64_ViewIterator(this, 0);};
+
+    /**
+     * @brief get an iterator past the last byte
+     *
+     * @return W25Q64_ViewIterator iterator at the end of the view
+     */
+    W25Q64_ViewIterator end(){return W25Q64_ViewIterator(this, _len);};
+
+    /**
+     * @brief get the length of the view
+     *
+     * @return unsigned int bytes in the view
+     */
+    unsigned int size(){return _len;};
+
+    /**
+     * @brief get the number of page lookups served from the cache
+     *
+     * @return unsigned long hits
+     */
+    unsigned long hits(){return _hits;};
+
+    /**
+     * @brief get the number of page lookups that read the chip
+     *
+     * @return unsigned long misses
+     */
+    unsigned long misses(){return _misses;};
+
+private:
+    W25Q64* _flash; ///< flash chip used
+    unsigned int _start; ///< chip address of offset 0
+    unsigned int _len; ///< length of the view
+    W25Q64_View_line_t _lines[W25Q64_VIEW_SETS][W25Q64_VIEW_WAYS]; ///< cached pages
+    byte _data[W25Q64_VIEW_WAYS * W25Q64_VIEW_SETS][W25Q64_PAGE_SIZE]; ///< page contents, row way * sets + set, so consecutive pages can share a read
+    unsigned long _clock; ///< access counter for LRU
+    unsigned int _last_fetched; ///< last page read from the chip, for sequential detection
+    unsigned long _hits; ///< lookups served from the cache
+    unsigned long _misses; ///< lookups that read the chip
+
+    /**
+     * @brief find a page in the cache, reading it in on a miss
+     *
+     * @return W25Q64_View_line_t* line holding the page, NULL if it could not be read
+     */
+    W25Q64_View_line_t* _line(unsigned int page);
+
+    /**
+     * @brief read a run of pages with one fastRead, the first into the least recently used line of its set and the
+     *  rest into the rows that follow it
+     *
+     * @return W25Q64_View_line_t* line holding the first page, NULL if the run could not be read
+     */
+    W25Q64_View_line_t* _fetch(unsigned int page, unsigned int count);
+
+    /**
+     * @brief check if a page is in the cache without touching the LRU state
+     *
+     */
+    bool _cached(unsigned int page);
+};
+
+#endif